@@ -0,0 +1,53 @@
+/*
+* Cards
+* Copyright (C) Zach Wilder 2024
+* 
+* This file is a part of Cards
+*
+* Cards is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+* 
+* Cards is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+* 
+* You should have received a copy of the GNU General Public License
+* along with Cards.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#ifndef ARENA_H
+#define ARENA_H
+
+/*****
+ * A simple bump allocator. One block is malloc'd when the arena is created,
+ * arena_alloc() hands out pieces of it, and arena_reset() takes everything
+ * back at once (O(1), nothing is freed one at a time). Anything allocated
+ * from an arena is only good until the next reset.
+ *
+ * If an arena runs out of room the piece comes from the heap instead (and is
+ * freed on the next reset), so a game that sized its arena wrong still works
+ * - arena_heap_allocs() counts how often that's happened, which should be
+ * never.
+ *****/
+
+#define ARENA_ALIGN 16
+
+typedef struct {
+    uint8_t *base;
+    size_t size;
+    size_t used;
+    unsigned long allocs; // Pieces handed out since the last reset
+    unsigned long resets;
+    void *overflow; // Heap blocks handed out since the last reset, a list
+} Arena;
+
+Arena* create_arena(size_t size);
+void destroy_arena(Arena *arena);
+void* arena_alloc(Arena *arena, size_t size);
+void arena_reset(Arena *arena);
+size_t arena_size_for(size_t size, int count);
+unsigned long arena_heap_allocs(void); // Every arena, since the program started
+
+#endif //ARENA_H
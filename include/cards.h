@@ -24,6 +24,7 @@
  * Toolbox
  *****/
 #include <mt19937.h>
+#include <rng.h>
 #include <vec2i.h>
 #include <rect.h>
 #include <slist.h>
@@ -34,8 +35,14 @@
  * Cards - Project
  *****/
 #include <flags.h>
+#include <arena.h>
 #include <deck.h>
+#include <journal.h>
 #include <button.h>
+#include <hitgrid.h>
+#include <timer_wheel.h>
+#include <latency.h>
+#include <game_loop.h>
 #include <settings.h>
 #include <high_scores.h>
 #include <save.h>
@@ -59,5 +66,7 @@ void help_about(void); // help.c
 void help_penguin(void); // help.c
 void help_klondike(void); // help.c
 long current_ms(void); // solitaire.c
+int run_bench(void); // bench.c
+int run_shuffle_test(long n, unsigned long seed); // shuffle_test.c
 
 #endif //CARDS_H
@@ -20,6 +20,10 @@
 #ifndef CRIBBAGE_H
 #define CRIBBAGE_H
 
+#define CR_CPU_DELAY 750 // ms the cpu "thinks" before playing a card
+#define CR_MSG_SZ 80 // Longest message, one line of the standard screen
+#define CR_MSG_LINES 4 // How many messages stay on the screen
+
 typedef enum {
     CR_PLAYER           = 0,
     CR_CPU,
@@ -29,14 +33,24 @@ typedef enum {
     CR_NUM_DECKS
 } CribbageDecks;
 
+typedef enum {
+    // Steps of the show (counting hands), one for each "press any key"
+    CR_SHOW_START       = 0,
+    CR_SHOW_FIRST, // Hand of the player without the crib
+    CR_SHOW_SECOND, // Hand of the player with the crib
+    CR_SHOW_CRIB
+} CribShowStep;
+
 typedef struct {
     uint8_t qty;
     uint8_t pts;
-    char *msg;
+    char msg[CR_MSG_SZ];
 } CribScore;
 
 typedef struct {
     Deck **decks;
+    Arena *arena; // Where the decks and cards come from
+    Shoe *shoe; // The cards
     uint32_t flags; // GameFlags defined in flags.h
     bool pcrib; // Player crib
     bool pturn; // CPU crib
@@ -48,9 +62,15 @@ typedef struct {
     uint8_t cScore; // Computer score
     uint8_t count; // Value on table
     Button **btns;
-    char *msg; 
-    SList *msglist;
-    uint8_t msgpos;
+    char msgs[CR_MSG_LINES][CR_MSG_SZ]; // Ring of the last few messages
+    uint8_t msgpos; // Slot in msgs the next message goes in
+    uint8_t msgcount; // How many of msgs have something in them
+    HitGrid *hits; // Where mouse clicks land, see hitgrid.h
+    GameLoop *loop; // Events/update/draw functions and loop timing
+    int cputimer; // Timer for the cpu's next play, -1 if none
+    uint8_t showstep; // CribShowStep, where the show is at
+    Rng rng; // Shuffles and the cpu player's choices, see rng.h
+    uint64_t deal; // Deal number the game started from, see shuffle_deal()
 } Cribbage;
 
 extern Cribbage *g_cribbage;
@@ -61,13 +81,15 @@ bool cribbage_init(void);
 void cribbage_cleanup(void);
 void cribbage_clear_msg(void);
 void cribbage_msg(char *fstr, ...);
-char cribbage_prompt(char *fstr, ...);
-void cribbage_loop(void);
+char* cribbage_get_msg(int i);
+void cribbage_prompt(PromptFn fn, char *fstr, ...);
+bool cribbage_click(KeyEvent *key);
 
 /*****
  * cribbage_events.c
  *****/
-void cribbage_events(void);
+void cribbage_events(KeyEvent *key);
+void cribbage_quit_answer(char answer, void *data);
 
 /*****
  * cribbage_update.c
@@ -79,19 +101,19 @@ void cribbage_deal(void);
  * cribbage_draw.c
  *****/
 void cribbage_draw(void);
+void cribbage_layout(HitGrid *hits);
 
 /*****
  * cribscore.c
  *****/
 int cribbage_card_value(int card);
-CribScore* create_cribscore(int qty, int pts, char *msg,...);
-void destroy_cribscore(CribScore *score);
-CribScore* score_cribbage_hand(Card *hand, Card *flop);
-CribScore* score_cribbage_play(Deck *deck);
-CribScore* count_runs(Card *hand, Card *flop);
-CribScore* count_flush(Card *hand, Card *flop);
-CribScore* count_15s(Card *hand, Card *flop);
-CribScore* count_pairs(Card *hand, Card *flop);
-CribScore* count_nobs(Card *hand, Card *flop);
+CribScore make_cribscore(int qty, int pts, char *msg,...);
+CribScore score_cribbage_hand(Deck *hand, Card *flop);
+CribScore score_cribbage_play(Deck *deck);
+CribScore count_runs(Deck *hand, Card *flop);
+CribScore count_flush(Deck *hand, Card *flop);
+CribScore count_15s(Deck *hand, Card *flop);
+CribScore count_pairs(Deck *hand, Card *flop);
+CribScore count_nobs(Deck *hand, Card *flop);
 
 #endif //CRIBBAGE_H
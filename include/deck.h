@@ -22,6 +22,7 @@
 
 typedef struct Card Card;
 typedef struct Deck Deck;
+typedef uint64_t CardSet; // Bit i is set if the card with id i is in the set
 
 typedef enum {
     CD_NONE     = 1 << 0,
@@ -47,52 +48,133 @@ typedef enum {
     CD_CPU      = 1 << 20
 } CardFlags;
 
+#define CD_RANKS (CD_A | CD_2 | CD_3 | CD_4 | CD_5 | CD_6 | CD_7 | CD_8 | \
+        CD_9 | CD_10 | CD_J | CD_Q | CD_K)
+#define CD_SUITES (CD_H | CD_S | CD_C | CD_D)
+#define CARD_IDS 52 // Every card has an id from 0 to 51, see card_id()
+
+#define DECK_CARDS 52 // Cards in one standard deck, see fill_deck_in()
+#define DECK_MAX DECK_CARDS // Room in a pile for one deck of cards
+#define SHOE_MAX_DECKS 8 // Most standard decks in one shoe
+#define PILE_MAX (DECK_CARDS * SHOE_MAX_DECKS) // Most room any pile can have
+#define CARDSET_ALL (((CardSet)1 << CARD_IDS) - 1) // Every card id
+
 struct Card {
     uint32_t flags;
-    Card *next;
-    Card *prev;
+    uint16_t serial; // Which card of the shoe this is, copy * 52 + card id
 };
 
 struct Deck {
     /*
-     * Deck contains a linked list of cards, an integer count of how many cards
-     * are in the deck (I guess I could properly call that a uint8_t), and an
-     * integer id
+     * Deck holds its cards in an array that's allocated along with it, room
+     * for cap cards (enough for the whole shoe, in games with more than one
+     * deck of cards) - the first card (the bottom of the pile) is cards[0],
+     * the last card is cards[count - 1], and that's the top of every pile,
+     * tableaus and the stock alike. Adding/taking/drawing the top card,
+     * looking at any card, and counting the cards are all just an array
+     * access. count is the number of cards in the deck, id is an
+     * integer id. set has a bit for every card in the deck (by card id), so
+     * "is there a 5 in here?" or "how many hearts?" is a mask and a popcount
+     * instead of a walk through the cards. With more than one deck of cards
+     * there can be a few of the same card, copies[] counts them so the bit
+     * only goes away with the last one. Both are kept up to date by
+     * everything in deck.c that adds or takes cards.
      */
-    Card *cards;
-    uint8_t count;
-    uint8_t id;
+    CardSet set;
+    uint16_t count;
+    uint16_t cap;
+    uint16_t id;
+    uint8_t copies[CARD_IDS];
+    Card *cards[]; // cap of them, see deck_size_for()
 };
 
+typedef struct {
+    /*
+     * A shoe is every card in a game - decks standard decks of 52, made all
+     * at once. Card i of the shoe always has serial i, so cards can be told
+     * apart (and found again) even when there's more than one of the same.
+     */
+    Card *cards;
+    uint16_t size;
+    uint8_t decks;
+} Shoe;
+
+typedef struct {
+    /*
+     * Everything the games ask about a card, looked up by card id instead of
+     * being worked out from the flags every time. The relation tables are
+     * bitmaps of card ids - bit j of stacks[i] is set if card j can go on
+     * card i. Filled in once by init_card_tables().
+     */
+    uint32_t cflags[CARD_IDS]; // Rank | suite flags for the id
+    uint8_t rank[CARD_IDS]; // 1 (A) to 13 (K)
+    char rank_ch[CARD_IDS]; // A23456789TJQK
+    char suite[CARD_IDS]; // h, s, c, d
+    bool red[CARD_IDS];
+    uint8_t value[CARD_IDS]; // Cribbage count, face cards are 10
+    char rank_str[CARD_IDS][3]; // "A", "10", "K"...
+    char suite_str[CARD_IDS][4]; // Suite symbol (UTF-8)
+    char name[CARD_IDS][8]; // Suite symbol and rank, like "♥10"
+    CardSet stacks[CARD_IDS]; // Klondike tableau, one lower and other color
+    CardSet follows[CARD_IDS]; // Same suite, one higher (foundations)
+    CardSet wraps[CARD_IDS]; // Same as follows, but an A follows a K (Penguin)
+    CardSet ranks[14]; // All four cards of a rank, by rank (1 - 13)
+    CardSet suites[4]; // All 13 cards of a suite, in id order (H, S, C, D)
+    uint8_t rank_order[CARD_IDS]; // Sort key by rank, then suite (0 - 51)
+    uint8_t suite_order[CARD_IDS]; // Sort key by suite (C, H, S, D), then rank
+} CardTables;
+
+extern CardTables g_cardtab;
+
 /*****
- * Card (Linked List) functions
+ * Card functions
  *****/
-Card* create_card(int cflags);
-void destroy_card(Card *card);
-int count_cards(Card *card);
+Card* create_card_in(Arena *arena, int cflags);
+int count_cards(Deck *deck);
 
 /*****
  * Deck functions
  *****/
-Deck* create_deck(void);
-void destroy_deck(Deck *deck);
+Deck* create_deck_in(Arena *arena, int cap);
+size_t deck_size_for(int cap);
 void add_card_to_deck(Deck *deck, Card *card);
-void fill_deck(Deck *deck);
-Card* search_cards(Card *cards, int cflags);
+void fill_deck_in(Deck *deck, Arena *arena);
+
+/*****
+ * Shoe functions
+ *****/
+Shoe* create_shoe_in(Arena *arena, int decks);
+size_t shoe_size_for(int decks);
+void fill_deck_from_shoe(Deck *deck, Shoe *shoe);
 Card* search_deck(Deck *deck, int cflags);
+int find_card_in_deck(Deck *deck, Card *card);
 Card* remove_card_from_deck(Deck *deck, Card *card);
+Card* remove_card_at(Deck *deck, int n);
+Card* pop_card(Deck *deck);
 void draw_card(Deck *from, Deck *to);
 void draw_cards(Deck *from, Deck *to, int n);
 void add_deck(Deck *from, Deck *to);
 void move_top_card_to_deck(Deck *from, Deck *to);
 void move_last_card_to_deck(Deck *from, Deck *to);
 void move_chain_card(Card *card, Deck *from, Deck *to);
+bool splice_cards(Deck *from, int i, Deck *to, bool reverse);
+void swap_cards(Deck *a, int i, Deck *b, int j);
+Card* get_first_card(Deck *deck);
 Card* get_last_card(Deck *deck);
 Card* get_card_at(Deck *deck, int n);
 
 /*****
  * Deck interaction
  *****/
+void init_card_tables(void);
+int card_id(int cflags);
+CardSet card_bit(int cflags);
+CardSet cardset_of(int cflags);
+CardSet cardset_worth_upto(int value);
+int cardset_count(CardSet set);
+bool card_stacks_on(int a, int b);
+bool card_follows(int a, int b);
+bool card_follows_wrap(int a, int b);
 int get_card(int value, char suite);
 bool card_hearts(int card);
 bool card_diamonds(int card);
@@ -110,16 +192,26 @@ char get_rank_ch(int card);
 int get_rank_flag(int card);
 int get_suite_flag(int card);
 uint32_t rank_to_cflag(int rank);
-char* get_card_str(Card *card);
-void shuffle_deck(Deck *deck);
+const char* get_card_str(Card *card); // Interned, don't free
+void shuffle_deck(Deck *deck); // Shuffle with the default stream, g_rng
+void shuffle_deck_rng(Deck *deck, Rng *rng);
+void shuffle_deck_bulk(Deck *deck, RngBulk *bulk); // For batch jobs, see rng.h
+
+/*****
+ * Numbered deals, like FreeCell's - the same deal number is always the same
+ * shuffle, so a game can be shared, replayed or used to pin down a bug.
+ *****/
+void set_next_deal(uint64_t deal); // The next game started plays this deal
+uint64_t peek_next_deal(void); // 0 if it'll be a random one
+uint64_t take_next_deal(void);
+bool parse_deal(const char *str, uint64_t *deal); // false if it isn't a deal
+void shuffle_deal(Deck *deck, Rng *rng, uint64_t deal);
 
 /*****
  * Card/Deck sorting
  *****/
-void merge_sort_deck(Deck *deck);
-void merge_sort_cards(Card **headref);
-void merge_sort_cards_bysuite(Card **headref, bool bysuite);
-void merge_sort_deck_bysuite(Deck *deck, bool bysuite);
+void sort_deck(Deck *deck);
+void sort_deck_bysuite(Deck *deck, bool bysuite);
 
 /*****
  * Deck drawing
@@ -0,0 +1,100 @@
+/*
+* Cards
+* Copyright (C) Zach Wilder 2024
+* 
+* This file is a part of Cards
+*
+* Cards is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+* 
+* Cards is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+* 
+* You should have received a copy of the GNU General Public License
+* along with Cards.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#ifndef GAME_LOOP_H
+#define GAME_LOOP_H
+
+/*****
+ * The events-update-draw loop shared by all of the games. Each game hands it a
+ * small table of functions and a pointer to its GameFlags, and the loop takes
+ * care of batching typed-ahead keys, mouse clicks, keeping draws under the
+ * frame budget, running timers, asking the player questions without blocking,
+ * and sleeping while nothing is happening.
+ *****/
+
+#define LOOP_MAX_BATCH 64 // Most typed-ahead keys handled before a redraw
+#define LOOP_FRAME_MS 33 // Minimum ms between draws (~30 draws a second)
+#define LOOP_PROMPT_SZ 80 // Longest prompt, one line of the standard screen
+#define LOOP_LATENCY_ENV "CARDS_LATENCY" // File to write loop stats to on exit
+
+/*
+ * Called with the (uppercased) key the player answered a prompt with. Since
+ * the loop keeps running while the prompt is up, this is where the game picks
+ * up again instead of waiting on a blocking read.
+ */
+typedef void (*PromptFn)(char answer, void *data);
+
+typedef struct {
+    char text[LOOP_PROMPT_SZ];
+    PromptFn fn; // What to do with the answer, NULL for "press any key"
+    void *data;
+    bool active;
+} LoopPrompt;
+
+typedef struct {
+    // Time spent in each phase, in microseconds
+    long events_us;
+    long update_us;
+    long draw_us;
+    long timers_us;
+    long idle_us;
+    long max_frame_us; // Longest single pass through the loop (not counting idle)
+    unsigned long frames; // Passes through the loop
+    unsigned long draws;
+    unsigned long keys;
+    unsigned long timers; // Timers that went off
+    unsigned long wakeups; // Times the loop woke up from idle
+    unsigned long deals; // Games dealt with this loop (restarts reuse it)
+    unsigned long deal_allocs; // Times the last deal went past its arena, see arena.h
+} LoopStats;
+
+typedef struct {
+    char *name; // Which game this is, for the stats
+    void (*events)(KeyEvent *key); // Handle one key
+    void (*update)(void); // Advance the game after each key (or on a wakeup)
+    void (*draw)(void); // Redraw, only called when GFL_DRAW is set
+    void (*tick)(void); // Called when timers go off (or the timerfd does), optional
+    bool (*click)(KeyEvent *key); // Turn a click into a key, optional
+    uint32_t *flags; // The game's GameFlags (GFL_RUNNING, GFL_DRAW...)
+    int frame_ms; // Frame budget, defaults to LOOP_FRAME_MS
+    long last_draw_us;
+    TimerWheel timers; // Timed events, the loop sleeps until the next one
+    LoopPrompt prompt; // Question waiting on an answer, if active
+    LoopStats stats;
+    LatencyHist latency; // Time from reading a key to the frame showing it
+    long keywait[LOOP_MAX_BATCH]; // Read times of keys not drawn yet
+    int nkeywait;
+} GameLoop;
+
+GameLoop* create_game_loop(uint32_t *flags);
+void destroy_game_loop(GameLoop *loop);
+void game_loop_reset(GameLoop *loop);
+void game_loop_run(GameLoop *loop);
+int game_loop_after(GameLoop *loop, long ms, TimerFn fn, void *data);
+void game_loop_cancel(GameLoop *loop, int id);
+void game_loop_prompt(GameLoop *loop, PromptFn fn, void *data, char *fstr, ...);
+void game_loop_show_stats(GameLoop *loop);
+void game_loop_write_stats(GameLoop *loop, FILE *fp);
+void game_loop_vprompt(GameLoop *loop, PromptFn fn, void *data, char *fstr,
+        va_list args);
+long loop_us(void);
+
+#endif //GAME_LOOP_H
@@ -28,11 +28,12 @@ struct Highscore {
     char *name;
     int datelength;
     char *date;
+    uint64_t deal; // Deal number the score was on, 0 if it's from before those
 };
 
 void high_scores(void); // Should really be called "show_high_scores" TODO
 Highscore* create_highscores(void);
 void cleanup_high_scores(Highscore *scores);
-void add_new_score_chrono(Highscore *scores, int score);
+void add_new_score_chrono(Highscore *scores, int score, uint64_t deal);
 #endif // HIGH_SCORES_H
 
@@ -0,0 +1,51 @@
+/*
+* Cards
+* Copyright (C) Zach Wilder 2024
+* 
+* This file is a part of Cards
+*
+* Cards is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+* 
+* Cards is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+* 
+* You should have received a copy of the GNU General Public License
+* along with Cards.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#ifndef HITGRID_H
+#define HITGRID_H
+
+/*****
+ * Hit grid: a lookup table from each cell of the standard 80x24 play area to
+ * the key that clicking on it should press. It is built from the Buttons and
+ * pile positions whenever the layout changes, so turning a mouse click into a
+ * key is a single array lookup.
+ *****/
+
+#define HG_WIDTH 80 // Same as SCREEN_WIDTH/SCREEN_HEIGHT in glyph.c
+#define HG_HEIGHT 24
+#define HG_STAMPSZ 64 // Bytes of game state that decide the layout
+
+typedef struct {
+    char cells[HG_WIDTH * HG_HEIGHT]; // Key for each cell, '\0' for nothing
+    uint8_t stamp[HG_STAMPSZ]; // Layout the grid was last built for
+    bool valid;
+} HitGrid;
+
+HitGrid* create_hitgrid(void);
+void destroy_hitgrid(HitGrid *hg);
+void hitgrid_clear(HitGrid *hg);
+bool hitgrid_stale(HitGrid *hg, uint8_t *stamp);
+void hitgrid_add(HitGrid *hg, int x, int y, int w, int h, char ch);
+void hitgrid_add_button(HitGrid *hg, Button *btn, int x, int y);
+char hitgrid_get(HitGrid *hg, int x, int y);
+bool hitgrid_click(HitGrid *hg, KeyEvent *key);
+
+#endif //HITGRID_H
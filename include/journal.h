@@ -0,0 +1,73 @@
+/*
+* Cards
+* Copyright (C) Zach Wilder 2024
+* 
+* This file is a part of Cards
+*
+* Cards is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+* 
+* Cards is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+* 
+* You should have received a copy of the GNU General Public License
+* along with Cards.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#ifndef JOURNAL_H
+#define JOURNAL_H
+
+/*****
+ * Undo/redo journal. Every change a move makes to the piles (or the score) is
+ * written down as one small fixed size record that says how to do it again
+ * and how to take it back - nothing about the piles is ever copied. The
+ * records for one player move are grouped into a step, undo walks back a step
+ * and redo walks forward one. The journal is a ring, so once it's full the
+ * oldest moves can't be undone anymore.
+ *****/
+
+#define JOURNAL_MAX 1024 // Records kept, a few moves' worth each
+
+typedef enum {
+    JR_MOVE = 0, // n cards off the end of "from" onto the end of "to"
+    JR_MOVE_REV, // Same, but the run is turned around (see splice_cards())
+    JR_DRAW, // n cards off the top of "from" onto "to", see draw_cards()
+    JR_FLIP, // Card n of "from" turned face up
+    JR_SWAP, // Card n of "from" traded with card arg of "to"
+    JR_SCORE // arg points added to the score
+} JournalOp;
+
+typedef enum {
+    JF_NONE = 0,
+    JF_STEP = 1 << 0 // First record of a player's move
+} JournalFlags;
+
+typedef struct {
+    uint8_t op; // JournalOp
+    uint8_t flags; // JournalFlags
+    uint8_t from; // Deck ids
+    uint8_t to;
+    uint16_t n;
+    int16_t arg;
+} JournalEntry;
+
+typedef struct {
+    JournalEntry *entries; // cap records, the ring
+    int cap;
+    int start; // Oldest record
+    int len; // Records in the ring
+    int pos; // Records that are done (the rest have been undone)
+    bool step; // The next record starts a new step
+} Journal;
+
+void journal_init(Journal *j, JournalEntry *entries, int cap);
+void journal_clear(Journal *j);
+void journal_step(Journal *j);
+void journal_add(Journal *j, int op, int from, int to, int n, int arg);
+bool journal_undo(Journal *j, Deck **decks, int *score);
+bool journal_redo(Journal *j, Deck **decks, int *score);
+
+#endif //JOURNAL_H
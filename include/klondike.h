@@ -38,18 +38,62 @@ typedef enum {
     KL_NUM_DECKS
 } KlondikeDecks;
 
+#define KL_DRAW 3 // Cards turned over off the stock at a time
+
+/*****
+ * Move generator, for searching through games (solvers, hints, simulating
+ * lots of deals) without the buttons, messages, score or undo journal.
+ * klondike_moves() writes every legal move from the piles in decks (a
+ * Klondike game's decks, by KlondikeDecks) to moves, which needs room for
+ * KL_MOVES_MAX of them, and returns how many there were. klondike_apply()
+ * makes a move and klondike_unapply() takes it back, leaving the piles
+ * exactly the way they were - moves have to be unapplied in the opposite
+ * order they were applied. Nothing is allocated.
+ *****/
+#define KL_MOVES_MAX 64 // Room to spare, see klondike_moves.c
+
+typedef enum {
+    KLM_DRAW = 0, // KL_DRAW cards (or what's left) from the stock to the waste
+    KLM_RECYCLE, // The waste back onto the empty stock
+    KLM_WASTE_FND, // Top of the waste onto its foundation
+    KLM_WASTE_TAB, // Top of the waste onto a tableau
+    KLM_TAB_FND, // Last card of a tableau onto its foundation
+    KLM_TAB_TAB // A run of n cards from one tableau onto another
+} KlondikeMoveKind;
+
+typedef enum {
+    KLF_NONE = 0,
+    KLF_FROM = 1 << 0, // The card left on the end of "from" was turned up
+    KLF_CARD = 1 << 1 // The card moved (off the waste) was turned up
+} KlondikeFlips;
+
+typedef struct {
+    uint8_t kind; // KlondikeMoveKind
+    uint8_t from; // KlondikeDecks
+    uint8_t to;
+    uint8_t n; // Cards moved
+    uint8_t flips; // KlondikeFlips, set by klondike_apply()
+} KlondikeMove;
+
 extern Solitaire* g_klondike;
 
 bool klondike_init(void);
 void klondike_cleanup(void);
 void klondike_deal(void);
+void klondike_deal_decks(Deck **decks);
 void klondike_loop(void);
-void klondike_events(void);
+void klondike_events(KeyEvent *key);
+bool klondike_click(KeyEvent *key);
 void klondike_pause(void);
 void klondike_update(void);
+void klondike_another_game(char answer, void *data);
 void klondike_fnd_move(void);
 void klondike_check_sequence(void);
 bool klondike_valid_move(int a, int b);
 void klondike_draw(void);
+void klondike_layout(HitGrid *hits);
+int klondike_moves(Deck **decks, KlondikeMove *moves);
+void klondike_apply(Deck **decks, KlondikeMove *move);
+void klondike_unapply(Deck **decks, KlondikeMove *move);
 
 #endif //KLONDIKE_H
@@ -0,0 +1,47 @@
+/*
+* Cards
+* Copyright (C) Zach Wilder 2024
+* 
+* This file is a part of Cards
+*
+* Cards is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+* 
+* Cards is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+* 
+* You should have received a copy of the GNU General Public License
+* along with Cards.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#ifndef LATENCY_H
+#define LATENCY_H
+
+/*****
+ * HDR style latency histogram. Values (microseconds) under 16 get a bucket
+ * each; past that every power of two is split into 16 linear buckets, so any
+ * value is off by at most ~6% no matter how big it is, and recording one is a
+ * couple of shifts. Covers up to 2^LH_MAXBITS us (over 12 days).
+ *****/
+
+#define LH_SUBBITS 4 // 16 buckets per power of two
+#define LH_SUB (1 << LH_SUBBITS)
+#define LH_MAXBITS 40
+#define LH_BUCKETS ((LH_MAXBITS - LH_SUBBITS + 1) * LH_SUB)
+
+typedef struct {
+    uint32_t counts[LH_BUCKETS];
+    unsigned long total; // Number of values recorded
+    long max;
+} LatencyHist;
+
+void lh_reset(LatencyHist *h);
+void lh_record(LatencyHist *h, long us);
+long lh_percentile(LatencyHist *h, double pct);
+
+#endif //LATENCY_H
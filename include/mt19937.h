@@ -47,7 +47,20 @@
 #include <stdbool.h>
 #include <limits.h>
 #include <time.h>
+#include <stdint.h>
 
+#define MT_N 624
+
+typedef struct {
+    uint32_t mt[MT_N]; // The state vector
+    int mti; // Next word of mt to hand out, MT_N+1 if not seeded yet
+} MtState;
+
+void mt_seed(MtState *st, unsigned long s);
+void mt_seed_by_array(MtState *st, unsigned long init_key[], int key_length);
+uint32_t mt_next(MtState *st);
+
+/* The original functions, which all use the default stream (g_rng) */
 void init_genrand(unsigned long s);
 void init_by_array(unsigned long init_key[], int key_length);
 unsigned long genrand_int32(void);
@@ -61,6 +74,7 @@ double genrand_res53(void);
  * Functions below added by Zach Wilder, 2022, with the same conditions as
  * above.
  */
+uint32_t mt_rand_below(uint32_t n);
 int mt_rand(int min, int max); 
 bool mt_bool(void); 
 bool mt_chance(int chance);
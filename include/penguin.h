@@ -53,11 +53,13 @@ bool penguin_init(void);
 void penguin_cleanup(void);
 void penguin_deal(void);
 void penguin_loop(void);
-void penguin_events(void);
+void penguin_events(KeyEvent *key);
+bool penguin_click(KeyEvent *key);
 /*****
  * penguin_update.c
  *****/
 void penguin_update(void);
+void penguin_another_game(char answer, void *data);
 void penguin_tableau_move(void);
 void penguin_foundation_move(void);
 void penguin_cell_swap(void);
@@ -69,6 +71,7 @@ int penguin_find_high_card(void);
  * penguin_draw.c
  *****/
 void penguin_draw(void); 
+void penguin_layout(HitGrid *hits);
 bool penguin_find_next_card(Card *card);
 
 #endif //PENGUIN_H
@@ -0,0 +1,118 @@
+/*
+* Cards
+* Copyright (C) Zach Wilder 2024
+* 
+* This file is a part of Cards
+*
+* Cards is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+* 
+* Cards is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+* 
+* You should have received a copy of the GNU General Public License
+* along with Cards.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#ifndef RNG_H
+#define RNG_H
+
+#include <mt19937.h>
+
+/*****
+ * Random number streams. Each Rng has its own state, so a game (or the cpu
+ * player, or a solver running in the background) can have its own stream
+ * that nothing else draws from - the same seed always gives the same
+ * numbers no matter what else is going on. g_rng is the default stream, it's
+ * what the old mt_rand()/genrand_int32() style functions use.
+ *
+ * There are two generators to pick from. xoshiro256** is the default - it's
+ * a handful of shifts and xors on 32 bytes of state, where MT19937 has to
+ * regenerate 2.5k of state every 624 numbers. MT19937 is still there for
+ * anything that wants it (build with -DRNG_DEFAULT=RNG_MT19937 to make it
+ * the default again). "Cards --bench" compares the two.
+ *****/
+typedef enum {
+    RNG_XOSHIRO         = 0, // xoshiro256**
+    RNG_MT19937
+} RngKind;
+
+#ifndef RNG_DEFAULT
+#define RNG_DEFAULT RNG_XOSHIRO
+#endif
+
+typedef struct {
+    uint8_t kind; // RngKind, which generator this stream uses
+    union {
+        uint64_t xs[4]; // xoshiro256** state, never all zero
+        MtState mt; // MT19937, see mt19937.c
+    };
+} Rng;
+
+extern Rng g_rng;
+
+void rng_init(Rng *rng, unsigned long seed); // Default generator
+void rng_init_kind(Rng *rng, RngKind kind, uint64_t seed);
+void rng_init_entropy(Rng *rng); // Seed from /dev/urandom, the clock and pid
+void rng_init_by_array(Rng *rng, RngKind kind, unsigned long key[], int len);
+uint32_t rng_u32(Rng *rng); // 0 to 2^32 - 1
+uint64_t rng_u64(Rng *rng); // 0 to 2^64 - 1
+uint32_t rng_bounded(Rng *rng, uint32_t n); // 0 to n - 1, no skew
+int rng_range(Rng *rng, int min, int max); // min to max (inclusive)
+bool rng_bool(Rng *rng);
+bool rng_chance(Rng *rng, int chance); // chance out of 100
+
+/*****
+ * Splitting one stream into many, for running things in parallel that need
+ * to come out the same every time. rng_split() hands out child streams by
+ * index - worker 3 always gets the same numbers from the same parent, no
+ * matter how many workers there are or what order they run in - so a whole
+ * batch can be replayed from the parent's seed.
+ *
+ * For xoshiro, child i is the parent jumped ahead (i + 1) * 2^192 numbers,
+ * so none of them can overlap each other or the parent. MT19937 can't jump
+ * cheaply, so its children are seeded from a hash of the parent's state and
+ * the index instead - different streams, but nothing promises they never
+ * overlap. Splitting is O(index), so hand out indexes from 0, not at random.
+ *****/
+void rng_jump(Rng *rng); // 2^128 numbers ahead (xoshiro only)
+void rng_long_jump(Rng *rng); // 2^192 numbers ahead (xoshiro only)
+void rng_split(Rng *child, Rng *parent, uint32_t index);
+
+/*****
+ * Bulk random numbers, for jobs that shuffle millions of decks (simulating
+ * games, building solver test sets...). RNG_BULK_LANES copies of xoshiro256**
+ * run side by side in vectors, so the compiler can step all of them with a
+ * few SIMD instructions, and rng_fill_u32() writes out a whole buffer at a
+ * time. Lane i is the stream it's seeded from jumped i * 2^128 ahead, and
+ * that stream is long jumped past them (rng_bulk_init_rng() changes it), so
+ * the lanes never overlap each other, the stream's later numbers, or another
+ * rng_split() child's lanes. Seeded from MT19937 it's just a xoshiro seed.
+ * Interactive play sticks with Rng, one number at a time.
+ *
+ * An RngBulk also keeps a buffer of its own, so rng_bulk_u32() and
+ * shuffle_deck_bulk() can take numbers out of it without a call per number.
+ *****/
+#define RNG_BULK_LANES 4
+#define RNG_BULK_SZ 256 // uint32_t's buffered in an RngBulk
+
+// 4 lanes of 64 bits. Only 16 byte aligned, so an RngBulk can come from
+// malloc() or an arena even if the compiler uses 32 byte AVX registers.
+typedef uint64_t RngLanes __attribute__((vector_size(32), aligned(16)));
+
+typedef struct {
+    RngLanes s[4]; // xoshiro256** state, s[word][lane]
+    uint32_t buf[RNG_BULK_SZ]; // Numbers ready to go
+    int pos; // Next number in buf, RNG_BULK_SZ when it needs filling
+} RngBulk;
+
+void rng_bulk_init(RngBulk *bulk, unsigned long seed);
+void rng_bulk_init_rng(RngBulk *bulk, Rng *rng); // Lanes from a xoshiro Rng
+void rng_fill_u32(RngBulk *bulk, uint32_t *out, size_t n);
+uint32_t rng_bulk_u32(RngBulk *bulk);
+uint32_t rng_bulk_bounded(RngBulk *bulk, uint32_t n); // 0 to n - 1, no skew
+
+#endif //RNG_H
@@ -41,6 +41,8 @@ struct Settings {
     int penguin_hs;
     int penguin_last;
     int penguin_wins;
+    uint64_t klondike_hs_deal; // Deal the high score was on, 0 if unknown
+    uint64_t penguin_hs_deal;
     Highscore *klondike_scores;
     Highscore *penguin_scores;
 };
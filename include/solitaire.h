@@ -20,26 +20,45 @@
 #ifndef SOLITAIRE_H
 #define SOLITAIRE_H
 
+#define SOL_MSG_MS 4000 // How long messages stay on the screen
+#define SOL_MSG_SZ 80 // Longest message, one line of the standard screen
+
 typedef struct {
-    void (*events)(void);
-    void (*update)(void);
-    void (*draw)(void);
+    GameLoop *loop; // Events/update/draw functions and loop timing
+    void (*layout)(HitGrid *hits); // Fill in the mouse hit grid
     uint8_t num_decks; // The number of decks (hands, tableaus etc)
     Deck **decks; // The "decks" (card spots) above
+    Arena *arena; // Where the decks and cards come from, see reset_solitaire()
+    Shoe *shoe; // All of the cards in the game
+    uint8_t shoe_decks; // How many standard decks of cards are in the shoe
     Button **btns; // Buttons for each deck above
     Deck *fromref; // A reference to where a move originates
     Deck *toref; // A reference to where the move is going
-    char *msg; // String pointer for messages
+    char msg[SOL_MSG_SZ]; // Message under the cards, empty if none
+    int msgtimer; // Timer that clears msg, -1 if none
     uint32_t flags; // GameFlags defined in flags.h
     int score; // Current game score
+    HitGrid *hits; // Where mouse clicks land, see hitgrid.h
+    Journal journal; // Moves that can be undone/redone, see journal.h
+    Rng rng; // This game's own random numbers, see rng.h
+    uint64_t deal; // Deal number, see shuffle_deal()
 } Solitaire;
 
 Solitaire* create_solitaire(uint8_t num_decks); // Create an empty soliaire game
+Solitaire* create_solitaire_shoe(uint8_t num_decks, uint8_t shoe_decks); // Same, with shoe_decks decks of cards
 void destroy_solitaire(Solitaire *game); // Destroy a solitaire game
+void reset_solitaire(Solitaire *game); // Empty it out for a new game
 void solitaire_msg(Solitaire *g, char *msg,...);
 long current_ms(void);
-void solitaire_loop(Solitaire *g);
+bool solitaire_click(Solitaire *g, KeyEvent *key);
 void solitaire_pause(Solitaire *g);
-char solitaire_prompt(char *fstr, ...);
+void solitaire_prompt(Solitaire *g, PromptFn fn, char *fstr, ...);
+bool solitaire_move(Solitaire *g, Deck *from, int i, Deck *to, bool reverse);
+void solitaire_draw(Solitaire *g, Deck *from, Deck *to, int n);
+void solitaire_flip(Solitaire *g, Deck *deck, int i);
+void solitaire_swap(Solitaire *g, Deck *a, int i, Deck *b, int j);
+void solitaire_score(Solitaire *g, int points);
+void solitaire_undo(Solitaire *g);
+void solitaire_redo(Solitaire *g);
 
 #endif // SOLITAIRE_H
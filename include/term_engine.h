@@ -54,6 +54,69 @@ typedef enum {
     ST_DIM          = 1 << 6
 } StyleFlags;
 
+typedef enum {
+    TE_NONE         = 0,
+    TE_INPUT        = 1 << 0,
+    TE_TIMER        = 1 << 1,
+    TE_RESIZE       = 1 << 2
+} TermEvents;
+
+/***********
+ * Key codes
+ ***********/
+/*
+ * Keys decoded from the input stream. Anything below KEY_UP is a plain unicode
+ * code point (so 'a' is 'a', Esc is 27, Enter is '\n'...), special keys are
+ * numbered past the end of unicode so the two can never collide.
+ */
+typedef enum {
+    KEY_NONE        = 0,
+    KEY_TAB         = 9,
+    KEY_ENTER       = 10,
+    KEY_ESC         = 27,
+    KEY_BACKSPACE   = 127,
+    KEY_UP          = 0x110000,
+    KEY_DOWN,
+    KEY_RIGHT,
+    KEY_LEFT,
+    KEY_HOME,
+    KEY_END,
+    KEY_INSERT,
+    KEY_DELETE,
+    KEY_PGUP,
+    KEY_PGDN,
+    KEY_BACKTAB,
+    KEY_F1,
+    KEY_F2,
+    KEY_F3,
+    KEY_F4,
+    KEY_F5,
+    KEY_F6,
+    KEY_F7,
+    KEY_F8,
+    KEY_F9,
+    KEY_F10,
+    KEY_F11,
+    KEY_F12,
+    KEY_MOUSE,
+    KEY_UNKNOWN
+} KeyCodes;
+
+typedef enum {
+    KM_NONE         = 0,
+    KM_SHIFT        = 1 << 0,
+    KM_ALT          = 1 << 1,
+    KM_CTRL         = 1 << 2
+} KeyMods;
+
+typedef struct {
+    int key; // Code point or KeyCodes
+    int mods; // KeyMods
+    int x; // Terminal cell clicked on (KEY_MOUSE only)
+    int y;
+    long us; // When the key was read, CLOCK_MONOTONIC microseconds
+} KeyEvent;
+
 /****************
  * The 8+8 Colors
  ****************/
@@ -102,6 +165,8 @@ typedef enum {
 void term_init(void);
 void term_close(void);
 void term_resize(int i);
+int term_wait(int timeout);
+void term_set_timer(long ms);
 
 /******************
  * Draw functions
@@ -141,6 +206,9 @@ void scr_draw_dbl_box(int x, int y, int w, int h);
  *******************/
 void kb_init(void);
 void kb_restore(void);
+bool kb_get_key(KeyEvent *ev);
+int kb_pending(void);
+unsigned int kb_block_count(void);
 char kb_get_bl_char(void);
 char kb_get_bl_char_cursor(int x, int y);
 char kb_get_char(void);
@@ -0,0 +1,72 @@
+/*
+* Cards
+* Copyright (C) Zach Wilder 2024
+* 
+* This file is a part of Cards
+*
+* Cards is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+* 
+* Cards is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+* 
+* You should have received a copy of the GNU General Public License
+* along with Cards.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#ifndef TIMER_WHEEL_H
+#define TIMER_WHEEL_H
+
+/*****
+ * Hierarchical timer wheel. Three levels of 64 slots each, the first level
+ * covering the next 64 ticks, the second the next 64*64, and the third the
+ * next 64*64*64 (about 43 minutes at 10ms a tick). Timers are moved down a
+ * level ("cascaded") as their time gets closer. Adding and cancelling are
+ * O(1), and since each level keeps a bitmap of which slots have timers in
+ * them, finding the next deadline is a couple of bit scans.
+ *
+ * Timers come out of a fixed pool, so nothing is allocated once the wheel is
+ * set up.
+ *****/
+
+#define TW_TICK_MS 10
+#define TW_LEVELS 3
+#define TW_SLOTS 64 // Slots per level, has to match the 64 bit bitmaps
+#define TW_BITS 6 // log2(TW_SLOTS)
+#define TW_MAX_TIMERS 32
+
+typedef void (*TimerFn)(void *data);
+
+typedef struct {
+    TimerFn fn;
+    void *data;
+    long expires; // Tick the timer goes off on
+    int16_t next; // Next/prev timer in the same slot (or free list), -1 = end
+    int16_t prev;
+    int8_t level; // -1 if the timer isn't in use
+    uint8_t slot;
+    uint16_t gen; // Bumped every time the timer is reused, for stale ids
+} Timer;
+
+typedef struct {
+    Timer timers[TW_MAX_TIMERS];
+    int16_t slots[TW_LEVELS][TW_SLOTS]; // First timer in each slot, -1 = empty
+    uint64_t used[TW_LEVELS]; // Bit set for each slot with timers in it
+    int16_t freelist;
+    long tick; // Current tick
+    long base_ms; // Time (ms) of tick 0
+    unsigned long fired; // Timers that have gone off so far
+} TimerWheel;
+
+void tw_init(TimerWheel *tw, long now_ms);
+int tw_add(TimerWheel *tw, long now_ms, long delay_ms, TimerFn fn, void *data);
+void tw_cancel(TimerWheel *tw, int id);
+void tw_advance(TimerWheel *tw, long now_ms);
+long tw_next(TimerWheel *tw, long now_ms);
+
+#endif //TIMER_WHEEL_H
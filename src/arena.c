@@ -0,0 +1,92 @@
+/*
+* Cards
+* Copyright (C) Zach Wilder 2024
+* 
+* This file is a part of Cards
+*
+* Cards is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+* 
+* Cards is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+* 
+* You should have received a copy of the GNU General Public License
+* along with Cards.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#include <cards.h>
+
+static unsigned long s_heap_allocs = 0; // See arena_heap_allocs()
+
+Arena* create_arena(size_t size) {
+    Arena *arena = malloc(sizeof(Arena));
+    arena->base = malloc(size);
+    arena->size = size;
+    arena->used = 0;
+    arena->allocs = 0;
+    arena->resets = 0;
+    arena->overflow = NULL;
+    return arena;
+}
+
+static void arena_free_overflow(Arena *arena) {
+    // Each heap block starts with a pointer to the next one
+    void *block = arena->overflow, *next = NULL;
+    while(block) {
+        next = *(void**)block;
+        free(block);
+        block = next;
+    }
+    arena->overflow = NULL;
+}
+
+void destroy_arena(Arena *arena) {
+    if(!arena) return;
+    arena_free_overflow(arena);
+    free(arena->base);
+    free(arena);
+}
+
+void* arena_alloc(Arena *arena, size_t size) {
+    /* A piece of the arena, or of the heap if it's out of room (see
+     * arena.h). The heap block has ARENA_ALIGN bytes in front of the piece
+     * for the list pointer, so the piece is aligned the same either way.
+     * Returns NULL only if the heap is out of room too. */
+    void *result = NULL;
+    uint8_t *block = NULL;
+    if(!arena) return NULL;
+    size = arena_size_for(size, 1);
+    if(arena->used + size > arena->size) {
+        block = malloc(ARENA_ALIGN + size);
+        if(!block) return NULL;
+        *(void**)block = arena->overflow;
+        arena->overflow = block;
+        arena->allocs += 1;
+        s_heap_allocs += 1;
+        return block + ARENA_ALIGN;
+    }
+    result = arena->base + arena->used;
+    arena->used += size;
+    arena->allocs += 1;
+    return result;
+}
+
+void arena_reset(Arena *arena) {
+    if(!arena) return;
+    arena_free_overflow(arena);
+    arena->used = 0;
+    arena->allocs = 0;
+    arena->resets += 1;
+}
+
+unsigned long arena_heap_allocs(void) {
+    return s_heap_allocs;
+}
+
+size_t arena_size_for(size_t size, int count) {
+    // Room needed in an arena for count things of size bytes each
+    return ((size + ARENA_ALIGN - 1) & ~(size_t)(ARENA_ALIGN - 1)) * count;
+}
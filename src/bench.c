@@ -0,0 +1,349 @@
+/*
+* Cards
+* Copyright (C) Zach Wilder 2024
+* 
+* This file is a part of Cards
+*
+* Cards is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+* 
+* Cards is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+* 
+* You should have received a copy of the GNU General Public License
+* along with Cards.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#include <cards.h>
+
+/*****
+ * Microbenchmarks, run with "Cards --bench". Most of them ask the same
+ * question about a pile two ways - walking the cards like the code used to,
+ * and with the pile's CardSet - and print how long a round of each took. The
+ * shoe ones check that moving cards doesn't slow down with more decks, the
+ * rng ones compare the two random number generators, and the Klondike one
+ * times the move generator a search would lean on.
+ *****/
+
+#define BENCH_ROUNDS 2000000
+#define BENCH_DEAL 1 // Same deal every run, so runs can be compared
+#define BENCH_WALK 256 // Deepest a random walk through a Klondike game goes
+
+static volatile long s_sink = 0; // Keeps the compiler from skipping the work
+
+static bool scan_has_rank(Deck *deck, int rflag) {
+    int i = 0;
+    for(i = 0; i < deck->count; i++) {
+        if(check_flag(deck->cards[i]->flags, rflag)) return true;
+    }
+    return false;
+}
+
+static bool scan_can_play(Deck *deck, int count) {
+    int i = 0;
+    for(i = 0; i < deck->count; i++) {
+        if(cribbage_card_value(deck->cards[i]->flags) + count <= 31) return true;
+    }
+    return false;
+}
+
+static int scan_count_suite(Deck *deck, int sflag) {
+    int i = 0, n = 0;
+    for(i = 0; i < deck->count; i++) {
+        if(check_flag(deck->cards[i]->flags, sflag)) n++;
+    }
+    return n;
+}
+
+static void bench_report(char *what, long scan_us, long set_us) {
+    printf("%-34s scan %7.2fns  set %7.2fns  (%.1fx)\n", what,
+            (scan_us * 1000.0) / BENCH_ROUNDS, (set_us * 1000.0) / BENCH_ROUNDS,
+            set_us ? (double)scan_us / set_us : 0.0);
+}
+
+static void bench_shoe(int decks) {
+    /* Take the last card off a full stock and put it back, over and over,
+     * then the same with a run of ten cards, then a Klondike draw off the top
+     * of the stock onto the waste (and drawn back, which undoes it) */
+    Arena *arena = create_arena(shoe_size_for(decks) +
+            2 * arena_size_for(deck_size_for(DECK_CARDS * decks), 1));
+    Shoe *shoe = create_shoe_in(arena, decks);
+    Deck *stock = create_deck_in(arena, shoe->size);
+    Deck *pile = create_deck_in(arena, shoe->size);
+    long start = 0, move_us = 0, run_us = 0, draw_us = 0;
+    long i = 0;
+    char what[40];
+    Rng rng;
+
+    fill_deck_from_shoe(stock, shoe);
+    shuffle_deal(stock, &rng, BENCH_DEAL);
+    start = loop_us();
+    for(i = 0; i < BENCH_ROUNDS; i++) {
+        move_last_card_to_deck(stock, pile);
+        move_last_card_to_deck(pile, stock);
+    }
+    move_us = loop_us() - start;
+    start = loop_us();
+    for(i = 0; i < BENCH_ROUNDS; i++) {
+        splice_cards(stock, stock->count - 10, pile, false);
+        splice_cards(pile, 0, stock, false);
+    }
+    run_us = loop_us() - start;
+    start = loop_us();
+    for(i = 0; i < BENCH_ROUNDS; i++) {
+        draw_cards(stock, pile, KL_DRAW);
+        draw_cards(pile, stock, KL_DRAW);
+    }
+    draw_us = loop_us() - start;
+    s_sink += stock->count;
+    snprintf(what, 40, "%d card shoe, card/run/draw", shoe->size);
+    printf("%-34s move %6.2fns  run %7.2fns  draw %6.2fns\n", what,
+            (move_us * 1000.0) / BENCH_ROUNDS, (run_us * 1000.0) / BENCH_ROUNDS,
+            (draw_us * 1000.0) / BENCH_ROUNDS);
+    destroy_arena(arena);
+}
+
+static void bench_rng(char *name, RngKind kind, Deck *deck) {
+    /* Raw draws, draws from 0 to 51, and whole shuffles of the deck */
+    Rng rng;
+    long start = 0, u32_us = 0, bnd_us = 0, shuf_us = 0;
+    long i = 0, n = 0;
+
+    rng_init_kind(&rng, kind, 5489);
+    start = loop_us();
+    for(i = 0, n = 0; i < BENCH_ROUNDS; i++) {
+        n += rng_u32(&rng);
+    }
+    u32_us = loop_us() - start;
+    s_sink += n;
+    start = loop_us();
+    for(i = 0, n = 0; i < BENCH_ROUNDS; i++) {
+        n += rng_bounded(&rng, DECK_CARDS);
+    }
+    bnd_us = loop_us() - start;
+    s_sink += n;
+    start = loop_us();
+    for(i = 0; i < BENCH_ROUNDS / 50; i++) {
+        shuffle_deck_rng(deck, &rng);
+    }
+    shuf_us = loop_us() - start;
+    printf("%-14s %6.1fM draws/s  %6.1fM draws 0-51/s  %7.0f shuffles/s\n",
+            name, u32_us ? BENCH_ROUNDS / (double)u32_us : 0.0,
+            bnd_us ? BENCH_ROUNDS / (double)bnd_us : 0.0,
+            shuf_us ? (BENCH_ROUNDS / 50) * 1000000.0 / shuf_us : 0.0);
+}
+
+static void bench_rng_bulk(Deck *deck) {
+    /* Same as bench_rng(), from an RngBulk - rng_fill_u32() a buffer at a
+     * time, then draws and shuffles out of its own buffer */
+    static RngBulk bulk;
+    uint32_t buf[RNG_BULK_SZ];
+    long start = 0, u32_us = 0, bnd_us = 0, shuf_us = 0;
+    long i = 0, n = 0;
+
+    rng_bulk_init(&bulk, 5489);
+    start = loop_us();
+    for(i = 0, n = 0; i < BENCH_ROUNDS; i += RNG_BULK_SZ) {
+        rng_fill_u32(&bulk, buf, RNG_BULK_SZ);
+        n += buf[i % RNG_BULK_SZ];
+    }
+    u32_us = loop_us() - start;
+    s_sink += n;
+    start = loop_us();
+    for(i = 0, n = 0; i < BENCH_ROUNDS; i++) {
+        n += rng_bulk_bounded(&bulk, DECK_CARDS);
+    }
+    bnd_us = loop_us() - start;
+    s_sink += n;
+    start = loop_us();
+    for(i = 0; i < BENCH_ROUNDS / 50; i++) {
+        shuffle_deck_bulk(deck, &bulk);
+    }
+    shuf_us = loop_us() - start;
+    printf("%-14s %6.1fM draws/s  %6.1fM draws 0-51/s  %7.0f shuffles/s\n",
+            "xoshiro x4", u32_us ? BENCH_ROUNDS / (double)u32_us : 0.0,
+            bnd_us ? BENCH_ROUNDS / (double)bnd_us : 0.0,
+            shuf_us ? (BENCH_ROUNDS / 50) * 1000000.0 / shuf_us : 0.0);
+}
+
+typedef struct {
+    // Everything about a pile klondike_unapply() has to put back
+    uint16_t count;
+    CardSet set;
+    uint8_t copies[CARD_IDS];
+    Card *cards[DECK_CARDS];
+    uint32_t flags[DECK_CARDS]; // Face up or not
+} PileSnap;
+
+static void snap_piles(Deck **decks, PileSnap *snap) {
+    int i = 0, j = 0;
+    memset(snap, 0, KL_NUM_DECKS * sizeof(PileSnap));
+    for(i = 0; i < KL_NUM_DECKS; i++) {
+        snap[i].count = decks[i]->count;
+        snap[i].set = decks[i]->set;
+        memcpy(snap[i].copies, decks[i]->copies, CARD_IDS);
+        for(j = 0; j < decks[i]->count; j++) {
+            snap[i].cards[j] = decks[i]->cards[j];
+            snap[i].flags[j] = decks[i]->cards[j]->flags;
+        }
+    }
+}
+
+static bool piles_match(Deck **decks, PileSnap *snap) {
+    PileSnap now[KL_NUM_DECKS];
+    snap_piles(decks, now);
+    return memcmp(now, snap, KL_NUM_DECKS * sizeof(PileSnap)) == 0;
+}
+
+static int bench_klondike_moves(void) {
+    /* Finding the moves from the deal, then a random walk through the game -
+     * find the moves, make one, and take them all back when it gets stuck or
+     * BENCH_WALK deep (which is what a depth first search does). Every time
+     * it's back at the deal the piles have to be exactly the way they were
+     * dealt, or klondike_unapply() is broken and the bench fails. */
+    Arena *arena = create_arena(KL_NUM_DECKS *
+            arena_size_for(deck_size_for(DECK_CARDS), 1) +
+            arena_size_for(sizeof(Card), DECK_CARDS));
+    Deck *decks[KL_NUM_DECKS];
+    KlondikeMove moves[KL_MOVES_MAX];
+    KlondikeMove walk[BENCH_WALK];
+    PileSnap dealt[KL_NUM_DECKS];
+    Rng rng;
+    long start = 0, gen_us = 0, walk_us = 0;
+    long i = 0, n = 0;
+    int depth = 0, count = 0, fails = 0;
+
+    for(i = 0; i < KL_NUM_DECKS; i++) {
+        decks[i] = create_deck_in(arena, DECK_CARDS);
+        decks[i]->id = i;
+    }
+    fill_deck_in(decks[KL_STOCK], arena);
+    shuffle_deal(decks[KL_STOCK], &rng, BENCH_DEAL);
+    klondike_deal_decks(decks);
+    snap_piles(decks, dealt);
+
+    start = loop_us();
+    for(i = 0, n = 0; i < BENCH_ROUNDS; i++) {
+        n += klondike_moves(decks, moves);
+    }
+    gen_us = loop_us() - start;
+    s_sink += n;
+    start = loop_us();
+    for(i = 0, n = 0; i < BENCH_ROUNDS; i++) {
+        count = klondike_moves(decks, moves);
+        n += count;
+        if(!count || (depth == BENCH_WALK)) {
+            while(depth) {
+                depth--;
+                klondike_unapply(decks, &walk[depth]);
+            }
+            if(!piles_match(decks, dealt)) fails++;
+            continue;
+        }
+        walk[depth] = moves[rng_bounded(&rng, count)];
+        klondike_apply(decks, &walk[depth]);
+        depth++;
+    }
+    walk_us = loop_us() - start;
+    s_sink += n;
+    while(depth) {
+        depth--;
+        klondike_unapply(decks, &walk[depth]);
+    }
+    if(!piles_match(decks, dealt)) fails++;
+    printf("%-34s gen %6.2fns  walk %6.2fns  (%.1f moves)\n",
+            "Klondike moves, gen/gen+apply", (gen_us * 1000.0) / BENCH_ROUNDS,
+            (walk_us * 1000.0) / BENCH_ROUNDS, (double)n / BENCH_ROUNDS);
+    if(fails) {
+        printf("FAILED: klondike_unapply() didn't put the deal back %d times\n",
+                fails);
+    }
+    destroy_arena(arena);
+    return fails;
+}
+
+int run_bench(void) {
+    Arena *arena = create_arena(2 * arena_size_for(deck_size_for(DECK_MAX), 1) +
+            arena_size_for(sizeof(Card), DECK_CARDS));
+    Deck *stock = create_deck_in(arena, DECK_MAX);
+    Deck *hand = create_deck_in(arena, DECK_MAX);
+    long start = 0, scan_us = 0, set_us = 0;
+    long i = 0, n = 0;
+    int rflag = 0;
+    Rng rng;
+
+    fill_deck_in(stock, arena);
+    shuffle_deal(stock, &rng, BENCH_DEAL);
+    // A cribbage hand of high cards, so the scan has to look at all of them
+    for(i = stock->count - 1; (i >= 0) && (hand->count < 4); i--) {
+        if(cribbage_card_value(stock->cards[i]->flags) == 10) {
+            add_card_to_deck(hand, remove_card_at(stock, i));
+        }
+    }
+    printf("%d rounds each, %d cards in the stock\n", BENCH_ROUNDS,
+            stock->count);
+
+    // Is there a card of this rank left? (penguin_deal looking for the beak)
+    start = loop_us();
+    for(i = 0, n = 0; i < BENCH_ROUNDS; i++) {
+        rflag = rank_to_cflag((i % 13) + 1);
+        n += scan_has_rank(stock, rflag);
+    }
+    scan_us = loop_us() - start;
+    s_sink += n;
+    start = loop_us();
+    for(i = 0, n = 0; i < BENCH_ROUNDS; i++) {
+        rflag = rank_to_cflag((i % 13) + 1);
+        n += ((stock->set & cardset_of(rflag)) != 0);
+    }
+    set_us = loop_us() - start;
+    s_sink += n;
+    bench_report("Rank left in the stock", scan_us, set_us);
+
+    // Can anything be played without going over 31? (cribbage_check_go)
+    start = loop_us();
+    for(i = 0, n = 0; i < BENCH_ROUNDS; i++) {
+        n += scan_can_play(hand, 22 + (i % 10));
+    }
+    scan_us = loop_us() - start;
+    s_sink += n;
+    start = loop_us();
+    for(i = 0, n = 0; i < BENCH_ROUNDS; i++) {
+        n += ((hand->set & cardset_worth_upto(31 - (22 + (i % 10)))) != 0);
+    }
+    set_us = loop_us() - start;
+    s_sink += n;
+    bench_report("Playable card in a hand", scan_us, set_us);
+
+    // How many of a suite are left?
+    start = loop_us();
+    for(i = 0, n = 0; i < BENCH_ROUNDS; i++) {
+        n += scan_count_suite(stock, CD_H << (i % 4));
+    }
+    scan_us = loop_us() - start;
+    s_sink += n;
+    start = loop_us();
+    for(i = 0, n = 0; i < BENCH_ROUNDS; i++) {
+        n += cardset_count(stock->set & g_cardtab.suites[i % 4]);
+    }
+    set_us = loop_us() - start;
+    s_sink += n;
+    bench_report("Cards of a suite in the stock", scan_us, set_us);
+
+    // Random numbers, for shuffle heavy things like simulating lots of deals
+    bench_rng("MT19937", RNG_MT19937, stock);
+    bench_rng("xoshiro256**", RNG_XOSHIRO, stock);
+    bench_rng_bulk(stock);
+
+    destroy_arena(arena);
+
+    // Moving cards around a big shoe should cost the same as a single deck
+    bench_shoe(1);
+    bench_shoe(SHOE_MAX_DECKS);
+
+    // Move generation for searching through Klondike games
+    return bench_klondike_moves();
+}
@@ -26,24 +26,21 @@ Cribbage *g_cribbage = NULL;
 /*****
  * Init, cleanup, deal, and loop functions
  *****/
-bool cribbage_init(void) {
-    bool ret_to_main = true;
+static void cribbage_reset(void) {
+    /* Get g_cribbage ready for a new game. The decks and cards all come out
+     * of the arena, so resetting it throws the last game's away at once and
+     * the decks are carved out of it again - nothing is malloc'd or freed. */
     int i = 0;
-
-    // Cleanup first if needed
-    if(g_cribbage) cribbage_cleanup();
-
-    // Allocate memory for Cribbage, decks, and buttons
-    g_cribbage = malloc(sizeof(Cribbage));
-    g_cribbage->decks = malloc(sizeof(Deck*) * CR_NUM_DECKS);
+    arena_reset(g_cribbage->arena);
+    g_cribbage->shoe = create_shoe_in(g_cribbage->arena, 1);
     for(i = 0; i < CR_NUM_DECKS; i++) {
-        g_cribbage->decks[i] = create_deck();
+        g_cribbage->decks[i] = create_deck_in(g_cribbage->arena, DECK_CARDS);
         g_cribbage->decks[i]->id = i;
     }
-    g_cribbage->btns = malloc(sizeof(Button*) * 6); //6 buttons, 1 for each card
     for(i = 0; i < 6; i++) {
-        g_cribbage->btns[i] = create_button(0,0,i,'a'+i);
+        g_cribbage->btns[i]->ch = 'a' + i;
         g_cribbage->btns[i]->active = true;
+        g_cribbage->btns[i]->selected = false;
     }
 
     // Set g_cribbage variables to initial values
@@ -54,22 +51,62 @@ bool cribbage_init(void) {
     g_cribbage->pScore = 0;
     g_cribbage->cScore = 0;
     g_cribbage->count = 0;
-    g_cribbage->msg = NULL;
-    g_cribbage->msglist = NULL;
     g_cribbage->msgpos = 0;
+    g_cribbage->msgcount = 0;
     g_cribbage->flags = GFL_NONE;
+    g_cribbage->hits->valid = false;
+    game_loop_reset(g_cribbage->loop);
+    g_cribbage->cputimer = -1;
+    g_cribbage->showstep = CR_SHOW_START;
+}
+
+bool cribbage_init(void) {
+    bool ret_to_main = true;
+    unsigned long allocs = 0;
+    int i = 0;
 
-    // Put 52 cards in the stock, and shuffle it
-    fill_deck(g_cribbage->decks[CR_STOCK]);
-    shuffle_deck(g_cribbage->decks[CR_STOCK]);
+    // Anything carved out for this deal that didn't fit in the arena
+    allocs = arena_heap_allocs();
+
+    // A restart reuses the game that's already there, see cribbage_reset()
+    if(!g_cribbage) {
+        // Allocate memory for Cribbage, decks, and buttons
+        g_cribbage = malloc(sizeof(Cribbage));
+        g_cribbage->decks = malloc(sizeof(Deck*) * CR_NUM_DECKS);
+        g_cribbage->arena = create_arena(shoe_size_for(1) + CR_NUM_DECKS *
+                arena_size_for(deck_size_for(DECK_CARDS), 1));
+        g_cribbage->btns = malloc(sizeof(Button*) * 6); //6 buttons, 1 for each card
+        for(i = 0; i < 6; i++) {
+            g_cribbage->btns[i] = create_button(0,0,i,'a'+i);
+        }
+        g_cribbage->hits = create_hitgrid();
+
+        // Register events/update/draw with the game loop
+        g_cribbage->loop = create_game_loop(&g_cribbage->flags);
+        g_cribbage->loop->name = "cribbage";
+        g_cribbage->loop->events = &cribbage_events;
+        g_cribbage->loop->update = &cribbage_update;
+        g_cribbage->loop->draw = &cribbage_draw;
+        g_cribbage->loop->click = &cribbage_click;
+    }
+    cribbage_reset();
+
+    // Put the 52 cards in the shoe in the stock, and shuffle it
+    fill_deck_from_shoe(g_cribbage->decks[CR_STOCK], g_cribbage->shoe);
+    g_cribbage->deal = take_next_deal();
+    shuffle_deal(g_cribbage->decks[CR_STOCK], &g_cribbage->rng,
+            g_cribbage->deal);
 
     // Deal the cards, draw the cards, enter the loop
     // cut deck to see who goes first here maybe?
     g_cribbage->pcrib = false; 
     g_cribbage->pturn = true;
+    cribbage_msg("Deal #%llu.", (unsigned long long)g_cribbage->deal);
     cribbage_deal();
+    g_cribbage->loop->stats.deals += 1;
+    g_cribbage->loop->stats.deal_allocs = arena_heap_allocs() - allocs;
     cribbage_draw();
-    cribbage_loop();
+    game_loop_run(g_cribbage->loop);
 
     // If the game is going to be restarted, do it here
     if(check_flag(g_cribbage->flags,GFL_RESTART)) {
@@ -86,12 +123,9 @@ bool cribbage_init(void) {
 void cribbage_cleanup(void) {
     if(!g_cribbage) return;
     int i = 0;
-    for(i = 0; i < CR_NUM_DECKS; i++) {
-        if(!g_cribbage->decks) break;
-        if(g_cribbage->decks[i]) {
-            destroy_deck(g_cribbage->decks[i]);
-        }
-    }
+    // The decks and cards all live in the arena
+    destroy_arena(g_cribbage->arena);
+    g_cribbage->arena = NULL;
     if(g_cribbage->decks) {
         free(g_cribbage->decks);
         g_cribbage->decks = NULL;
@@ -108,13 +142,14 @@ void cribbage_cleanup(void) {
         g_cribbage->btns = NULL;
     }
 
-    if(g_cribbage->msg) {
-        free(g_cribbage->msg);
-        g_cribbage->msg = NULL;
+    if(g_cribbage->hits) {
+        destroy_hitgrid(g_cribbage->hits);
+        g_cribbage->hits = NULL;
     }
 
-    if(g_cribbage->msglist) {
-        destroy_slist(&g_cribbage->msglist);
+    if(g_cribbage->loop) {
+        destroy_game_loop(g_cribbage->loop);
+        g_cribbage->loop = NULL;
     }
 
     if(g_cribbage) {
@@ -123,114 +158,57 @@ void cribbage_cleanup(void) {
     }
 }
 
-void cribbage_loop(void) {
-    /* Basic game loop, copied from the solitaire games. Since this isn't
-     * processor intensive, this keeps it from running as fast as it can - which
-     * may help on some terminal emulators to keep it from being "blinky". Also,
-     * it only redraws the screen when something changes, instead of every loop.
-     * Another "improvement" would be to only call the update routine when it
-     * needs to as well... maybe.
-     */
-    long prev = current_ms();
-    long lag = 0, current = 0, elapsed = 0;
-    long msperframe = 33; // 16ms = ~60fps, 33ms = ~30fps
-    g_cribbage->flags |= GFL_RUNNING;
-    while(check_flag(g_cribbage->flags, GFL_RUNNING)) {
-        current = current_ms();
-        elapsed = current - prev;
-        prev = current;
-        lag += elapsed;
-        cribbage_events();
-        cribbage_update();
-        if(check_flag(g_cribbage->flags,GFL_DRAW)) {
-            cribbage_draw();
-        }
-        if(check_flag(g_cribbage->flags,GFL_RESTART)) {
-            g_cribbage->flags &= ~GFL_RUNNING;
-        }
-        while(lag >= msperframe) {
-            lag -= msperframe;
-        }
-        if(check_flag(g_cribbage->flags,GFL_PAUSE)) {
-            // In case I need to pause the loop? Might be a good idea or a
-            // terrible idea. A better implementation would just loop, skipping
-            // the regular update/events and then end when the user enters a
-            // keypress. Update: No shocker here, it doesn't work well
-            //cribbage_prompt("Press any key to continue...");
-            g_cribbage->flags &= ~GFL_PAUSE;
-        }
+bool cribbage_click(KeyEvent *key) {
+    /* Turn a mouse click into the key for the card under it. The only thing
+     * that can be clicked is the player's hand, so the layout only changes
+     * with the size of the hand and which screen is being shown. */
+    uint8_t stamp[HG_STAMPSZ];
+    memset(stamp, 0, HG_STAMPSZ);
+    stamp[0] = g_cribbage->decks[CR_PLAYER]->count;
+    stamp[1] = check_flag(g_cribbage->flags, GFL_WIN);
+    stamp[2] = check_flag(g_cribbage->flags, GFL_CRIBSHOW);
+    if(hitgrid_stale(g_cribbage->hits, stamp)) {
+        hitgrid_clear(g_cribbage->hits);
+        cribbage_layout(g_cribbage->hits);
     }
+    return hitgrid_click(g_cribbage->hits, key);
 }
+
 void cribbage_clear_msg(void) {
     //Push 4 blank messages - might be ok to just destroy the message list?
-    //destroy_slist(&g_cribbage->msglist); // This is blinky?
+    //g_cribbage->msgcount = 0; // This is blinky?
     cribbage_msg(" ");
     cribbage_msg(" ");
     cribbage_msg(" ");
 }
 
 void cribbage_msg(char *fstr, ...) {
-    // Cribbage should maintain an SList of messages, and then print all of them
-    // in order on the screen
-    
-    if(!fstr) return;
-    SList *tmp = NULL;
-    char *msg = NULL;
+    // Cribbage keeps the last CR_MSG_LINES messages in a ring, and prints all
+    // of them in order on the screen. A new message just writes over the
+    // oldest one, so there's nothing to malloc or free.
     va_list args;
+    if(!fstr) return;
     va_start(args, fstr);
-    int i = vsnprintf(NULL, 0, fstr, args);
+    vsnprintf(g_cribbage->msgs[g_cribbage->msgpos], CR_MSG_SZ, fstr, args);
     va_end(args);
-    i += 1;
-    msg = malloc(sizeof(char) * i);
-    if(!msg) return;
-    va_start(args,fstr);
-    vsnprintf(msg, i, fstr, args);
-    va_end(args);
-
-    g_cribbage->msgpos += 1;
-    if(g_cribbage->msgpos > 4) {
-        tmp = slist_pop_node(&g_cribbage->msglist);
-        destroy_slist(&tmp);
-        slist_push(&g_cribbage->msglist,"%s",msg);
-    } else {
-        slist_push(&g_cribbage->msglist,"%s",msg);
-    }
-    free(msg);
+    g_cribbage->msgpos = (g_cribbage->msgpos + 1) % CR_MSG_LINES;
+    if(g_cribbage->msgcount < CR_MSG_LINES) g_cribbage->msgcount += 1;
 }
 
-char cribbage_prompt(char *fstr, ...) {
-    // Draw a prompt at the bottom of the screen, and wait for the user to
-    // return a keypress
-    char result = '\0';
-    int xo = (g_screenW / 2) - (SCREEN_WIDTH / 2); // Standard screen size is 80x24, defined in glyph.c
-    int yo = (g_screenH / 2) - (SCREEN_HEIGHT / 2);
-    if(!fstr) return result;
-    g_cribbage->flags |= GFL_DRAW;
-    cribbage_draw();
-
-    // Draw a blank line to "erase" the bottom of the screen
-    char *prompt = malloc(SCREEN_WIDTH * sizeof(char));
-    memset(prompt, ' ', SCREEN_WIDTH - 2);
-    prompt[SCREEN_WIDTH - 2] = '\0';
-    scr_pt_clr(0+xo,23+yo,WHITE,BLACK,prompt); 
+char* cribbage_get_msg(int i) {
+    // Message i of the ones on the screen, 0 being the oldest
+    if((i < 0) || (i >= g_cribbage->msgcount)) return NULL;
+    i += g_cribbage->msgpos + CR_MSG_LINES - g_cribbage->msgcount;
+    return g_cribbage->msgs[i % CR_MSG_LINES];
+}
 
-    // Format the prompt
+void cribbage_prompt(PromptFn fn, char *fstr, ...) {
+    // Draw a prompt at the bottom of the screen. The game loop waits for the
+    // user's keypress without blocking and hands it (upper case) to fn, which
+    // can be NULL for a plain "press any key".
     va_list args;
+    if(!fstr) return;
     va_start(args,fstr);
-    vsnprintf(prompt,SCREEN_WIDTH,fstr,args);
+    game_loop_vprompt(g_cribbage->loop, fn, NULL, fstr, args);
     va_end(args);
-    // Print the prompt
-    scr_pt_clr(xo,23+yo,WHITE,BLACK,prompt);
-
-    // Show the blinking cursor
-    // Get a char from the user
-    result = kb_get_bl_char_cursor(xo+strlen(fstr)+1,23+yo);
-
-    // Change result to upper case
-    if(result) {
-        result = toupper(result);
-    }
-
-    free(prompt);
-    return result;
 }
@@ -155,10 +155,9 @@ U+259x	▐	░	▒	▓	▔	▕	▖	▗	▘	▙	▚	▛	▜	▝	▞	▟
 */
     int xo = (g_screenW / 2) - (SCREEN_WIDTH / 2); // Standard screen size is 80x24, defined in glyph.c
     int yo = (g_screenH / 2) - (SCREEN_HEIGHT / 2);
-    int x = 0, y = 0, i = 0;
+    int x = 0, y = 0, i = 0, j = 0;
     Deck *deck = NULL;
     Card *cards = NULL;
-    SList *msgs = g_cribbage->msglist;
     uint8_t board_fg = WHITE; // Might be a settings option in the future?
     uint8_t board_bg = BRIGHT_BLACK;
 
@@ -172,67 +171,58 @@ U+259x	▐	░	▒	▓	▔	▕	▖	▗	▘	▙	▚	▛	▜	▝	▞	▟
         if(g_cribbage->pScore >= 61) {
             pt_card_title((SCREEN_WIDTH/2)-16+xo,yo,"YOU WON!");
         }
-        if(g_cribbage->msg) {
-            scr_pt_clr(xo,19+g_cribbage->msgpos+yo,WHITE,BLACK,"%s",g_cribbage->msg);
-        }
 
         //Draw message/prompt
-        i = 0;
-        while(msgs) {
-            if(msgs->next) {
-                scr_pt_clr(xo,19+i+yo,WHITE,BLACK,"%s",msgs->data);
+        for(i = 0; i < g_cribbage->msgcount; i++) {
+            if(i < g_cribbage->msgcount - 1) {
+                scr_pt_clr(xo,19+i+yo,WHITE,BLACK,"%s",cribbage_get_msg(i));
             } else {
-                scr_pt_clr(xo,19+i+yo,BRIGHT_WHITE,BLACK,"%s",msgs->data);
+                scr_pt_clr(xo,19+i+yo,BRIGHT_WHITE,BLACK,"%s",cribbage_get_msg(i));
             }
-            i += 1;
-            msgs = msgs->next;
         }
     } else if (check_flag(g_cribbage->flags, GFL_CRIBSHOW)) {
         // Draw crib
         y = (g_cribbage->pcrib ? 14 : 0);
         deck = g_cribbage->decks[CR_CRIB];
-        cards = deck->cards;
         x = 1;
-        while(cards) {
+        for(j = 0; j < deck->count; j++) {
+            cards = deck->cards[j];
             if(check_flag(cards->flags, CD_UP)) {
                 pt_card(x+xo,y+yo,cards);
             } else {
                 pt_card_back(x+xo,y+yo);
             }
             x += 4;
-            cards = cards->next;
         }
         scr_pt_clr(6+xo, y+yo+4, WHITE, BLACK, "Crib");
 
         // Draw player hand
         deck = g_cribbage->decks[CR_PLAYER];
-        cards = deck->cards;
         x = 54;
         y = 14;
-        while(cards) {
+        for(j = 0; j < deck->count; j++) {
+            cards = deck->cards[j];
             if(check_flag(cards->flags, CD_UP)) {
                 pt_card(x+xo,y+yo,cards);
             } else {
                 pt_card_back(x+xo,y+yo);
             }
             x += 4;
-            cards = cards->next;
         }
         scr_pt_clr(4+54+xo, y+yo+4, WHITE, BLACK, "Your hand");
 
         // Draw cpu hand
         deck = g_cribbage->decks[CR_CPU];
-        cards = deck->cards;
         x = 54;
         y = 0;
-        while(cards) {
+        for(j = 0; j < deck->count; j++) {
+            cards = deck->cards[j];
             if(check_flag(cards->flags, CD_UP)) {
                 pt_card(x+xo,y+yo,cards);
             } else {
                 pt_card_back(x+xo,y+yo);
             }
             x += 4;
-            cards = cards->next;
         }
         scr_pt_clr(4+54+xo, y+yo+4, WHITE, BLACK, "CPU hand");
 
@@ -241,69 +231,58 @@ U+259x	▐	░	▒	▓	▔	▕	▖	▗	▘	▙	▚	▛	▜	▝	▞	▟
         scr_pt_clr(37+xo,12+yo,WHITE,BLACK,"Count: %d",i);
 
         //Draw message/prompt
-        if(g_cribbage->msg) {
-            scr_pt_clr(xo,19+g_cribbage->msgpos+yo,WHITE,BLACK,"%s",g_cribbage->msg);
-        }
-        i = 0;
-        while(msgs) {
-            if(msgs->next) {
-                scr_pt_clr(xo,19+i+yo,WHITE,BLACK,"%s",msgs->data);
+        for(i = 0; i < g_cribbage->msgcount; i++) {
+            if(i < g_cribbage->msgcount - 1) {
+                scr_pt_clr(xo,19+i+yo,WHITE,BLACK,"%s",cribbage_get_msg(i));
             } else {
-                scr_pt_clr(xo,19+i+yo,BRIGHT_WHITE,BLACK,"%s",msgs->data);
+                scr_pt_clr(xo,19+i+yo,BRIGHT_WHITE,BLACK,"%s",cribbage_get_msg(i));
             }
-            i += 1;
-            msgs = msgs->next;
         }
     } else {
         // Draw crib
         y = (g_cribbage->pcrib ? 14 : 0);
         deck = g_cribbage->decks[CR_CRIB];
-        cards = deck->cards;
         i = 4;
-        while(cards){
+        for(j = 0; j < deck->count; j++) {
             pt_card_back(i+xo,y+yo);
             i -= 1;
-            cards=cards->next;
         }
 
         // Draw player hand
         deck = g_cribbage->decks[CR_PLAYER];
-        cards = deck->cards;
         x = 54;
         y = 14;
         i = 0;
-        while(cards) {
+        for(j = 0; j < deck->count; j++) {
+            cards = deck->cards[j];
             pt_card(x+xo,y+yo,cards);
             pt_button_at(g_cribbage->btns[i],x+xo,y+yo+4);
             x += 4;
             i += 1;
-            cards = cards->next;
         }
 
         // Draw cpu hand (for testing purposes)
         /*
         deck = g_cribbage->decks[CR_CPU];
-        cards = deck->cards;
         x = 54;
         y = 0;
         i = 0;
-        while(cards) {
+        for(j = 0; j < deck->count; j++) {
+            cards = deck->cards[j];
             pt_card(x+xo,y+yo,cards);
             x += 4;
             i += 1;
-            cards = cards->next;
         }
         */
 
         // Draw table cards
         deck = g_cribbage->decks[CR_BOARD];
-        cards = deck->cards;
         x = 20;
-        while(cards) {
+        for(j = 0; j < deck->count; j++) {
+            cards = deck->cards[j];
             y = (check_flag(cards->flags,CD_CPU) ? 0 : 13);
             x += 4;
             pt_card(x+xo,y+yo,cards);
-            cards = cards->next;
         }
 
         // Draw count
@@ -311,25 +290,19 @@ U+259x	▐	░	▒	▓	▔	▕	▖	▗	▘	▙	▚	▛	▜	▝	▞	▟
         scr_pt_clr(37+xo,12+yo,WHITE,BLACK,"Count: %d",i);
 
         //Draw message/prompt
-        if(g_cribbage->msg) {
-            scr_pt_clr(xo,19+g_cribbage->msgpos+yo,WHITE,BLACK,"%s",g_cribbage->msg);
-        }
-        i = 0;
-        while(msgs) {
-            if(msgs->next) {
-                scr_pt_clr(xo,19+i+yo,WHITE,BLACK,"%s",msgs->data);
+        for(i = 0; i < g_cribbage->msgcount; i++) {
+            if(i < g_cribbage->msgcount - 1) {
+                scr_pt_clr(xo,19+i+yo,WHITE,BLACK,"%s",cribbage_get_msg(i));
             } else {
-                scr_pt_clr(xo,19+i+yo,BRIGHT_WHITE,BLACK,"%s",msgs->data);
+                scr_pt_clr(xo,19+i+yo,BRIGHT_WHITE,BLACK,"%s",cribbage_get_msg(i));
             }
-            i += 1;
-            msgs = msgs->next;
         }
     }
 
     // Draw cut
     pt_card_back(14+xo,6+yo);
     if(!check_flag(g_cribbage->flags, GFL_CRIBDISC)) {
-        pt_card(14+xo,7+yo,g_cribbage->decks[CR_STOCK]->cards);
+        pt_card(14+xo,7+yo,get_last_card(g_cribbage->decks[CR_STOCK]));
     }
 
     // Draw Board
@@ -395,3 +368,15 @@ U+259x	▐	░	▒	▓	▔	▕	▖	▗	▘	▙	▚	▛	▜	▝	▞	▟
  small board. Keeping it here just for fun and because future me might have the
  wild idea to make a full size board again
 */
+
+void cribbage_layout(HitGrid *hits) {
+    /* Mouse targets: each card in the player's hand (and the button under it)
+     * presses that card's button. Only used while the hand is being played,
+     * the same as the buttons in cribbage_draw(). */
+    int i = 0;
+    if(check_flag(g_cribbage->flags, GFL_WIN)) return;
+    if(check_flag(g_cribbage->flags, GFL_CRIBSHOW)) return;
+    for(i = 0; (i < g_cribbage->decks[CR_PLAYER]->count) && (i < 6); i++) {
+        hitgrid_add(hits, 54 + (4*i), 14, 4, 5, g_cribbage->btns[i]->ch);
+    }
+}
@@ -23,12 +23,18 @@
  * Cribbage event functions
  *****/
 
-void cribbage_events(void) {
+void cribbage_quit_answer(char answer, void *data) {
+    if(answer == 'Y') {
+        g_cribbage->flags &= ~GFL_RUNNING;
+        g_cribbage->flags |= GFL_QTOMAIN;
+    }
+}
+
+void cribbage_events(KeyEvent *key) {
     bool redraw = false;
     bool btnselect = false;
     int i = 0;
-    char ch = kb_get_char();
-    switch(ch) {
+    switch(key->key) {
         case 'a':
             i = 0;
             btnselect = true;
@@ -61,12 +67,7 @@ void cribbage_events(void) {
             break;
         case 'q':
         case 'Q':
-            if(cribbage_prompt("Really quit? (y/n)") == 'Y') {
-                g_cribbage->flags &= ~GFL_RUNNING;
-                g_cribbage->flags |= GFL_QTOMAIN;
-            } else {
-                redraw = true;
-            }
+            cribbage_prompt(&cribbage_quit_answer, "Really quit? (y/n)");
             break;
         default: break;
     }
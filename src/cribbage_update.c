@@ -24,14 +24,21 @@ bool cribbage_check_go(Deck *deck);
 void cribbage_cpu_to_crib(void);
 void cribbage_update_discard(void);
 void cribbage_cpu_play(void);
+void cribbage_cpu_turn(void *data);
 void cribbage_update_count(void);
 bool cribbage_check_go(Deck *deck);
 void cribbage_check_win(void);
 void cribbage_add_points(int points, bool player);
 void cribbage_update_win(void);
 void cribbage_update_play(void);
-void cribbage_show_points(Card *hand, bool player, char *msg);
+void cribbage_show_points(Deck *hand, bool player, char *msg);
 void cribbage_update_show(void);
+void cribbage_show_hand(bool player);
+void cribbage_another_round(char answer, void *data);
+void cribbage_discard_answer(char answer, void *data);
+void cribbage_play_done(char answer, void *data);
+void cribbage_go_answer(char answer, void *data);
+void cribbage_player_go(char answer, void *data);
 
 /*****
  * Cribbage update assistance functions
@@ -56,15 +63,14 @@ void cribbage_deal(void) {
     add_deck(crib,stock);
 
     // Shuffle the cards
-    shuffle_deck(stock);
+    shuffle_deck_rng(stock, &g_cribbage->rng);
     
     // Remove flags from cards in stock
-    card = stock->cards;
-    while(card) {
+    for(i = 0; i < stock->count; i++) {
+        card = stock->cards[i];
         card->flags &= ~CD_UP;
         card->flags &= ~CD_PLAYER;
         card->flags &= ~CD_CPU;
-        card = card->next;
     }
 
     // Give 6 cards to the player, 6 cards to the cpu
@@ -74,19 +80,15 @@ void cribbage_deal(void) {
     }
 
     // Engage flags on player/cpu cards
-    card = playerhand->cards;
-    while(card) {
-        card->flags |= CD_PLAYER;
-        card = card->next;
+    for(i = 0; i < playerhand->count; i++) {
+        playerhand->cards[i]->flags |= CD_PLAYER;
     }
-    card = cpuhand->cards;
-    while(card) {
-        card->flags |= CD_CPU;
-        card = card->next;
+    for(i = 0; i < cpuhand->count; i++) {
+        cpuhand->cards[i]->flags |= CD_CPU;
     }
         
     // Sort the players hand
-    merge_sort_deck(playerhand);
+    sort_deck(playerhand);
 
     cribbage_msg("Choose two cards to add to %s crib:", 
             (g_cribbage->pcrib ? "your" : "the computer\'s"));
@@ -98,16 +100,12 @@ void cribbage_cpu_to_crib(void) {
     // The computer player is an idiot right now, and just chooses two random
     // cards from their hand. Eventually, it will analyze it's hand and choose
     // appropriate discards for it's skill level. 
-    int i = mt_rand(0,5);
+    int i = rng_range(&g_cribbage->rng,0,5);
     Deck *crib = g_cribbage->decks[CR_CRIB];
     Deck *cpuhand = g_cribbage->decks[CR_CPU];
-    add_card_to_deck(crib, 
-            remove_card_from_deck(cpuhand,
-                get_card_at(cpuhand,i)));
-    i = mt_rand(0,4);
-    add_card_to_deck(crib, 
-            remove_card_from_deck(cpuhand,
-                get_card_at(cpuhand,i)));
+    add_card_to_deck(crib, remove_card_at(cpuhand,i));
+    i = rng_range(&g_cribbage->rng,0,4);
+    add_card_to_deck(crib, remove_card_at(cpuhand,i));
 }
 
 void cribbage_cpu_play(void) {
@@ -126,8 +124,10 @@ void cribbage_cpu_play(void) {
     Deck *cpuhand = g_cribbage->decks[CR_CPU];
     Card *card = NULL;
     Card *choice = NULL;
-    int numcards = count_cards(cpuhand->cards);
-    int i = mt_rand(0,numcards-1); // -1 because 0 indexed
+    Card *last = get_last_card(board);
+    int numcards = cpuhand->count;
+    int j = 0;
+    int i = rng_range(&g_cribbage->rng,0,numcards-1); // -1 because 0 indexed
     int priority = 0;
     int valuecheck = 0;
     if(cribbage_check_go(cpuhand)) {
@@ -135,8 +135,8 @@ void cribbage_cpu_play(void) {
         cribbage_msg("CPU: I uh, don't have any cards to play boss.");
         return;
     }
-    card = cpuhand->cards;
-    while(card) {
+    for(j = 0; j < numcards; j++) {
+        card = cpuhand->cards[j];
         if((cribbage_card_value(card->flags) + g_cribbage->count) == 31) {
             // Check to see if any of the CPU's cards can be played to make 31
             if(priority < 5) {
@@ -150,9 +150,9 @@ void cribbage_cpu_play(void) {
                 priority = 4;
                 choice = card;
             }
-        } else if(get_last_card(board)) {
+        } else if(last) {
             // Check for pairs
-            if(get_rank(card->flags) == get_rank(get_last_card(board)->flags)) {
+            if(get_rank(card->flags) == get_rank(last->flags)) {
                 if(priority < 2) {
                     priority = 2;
                     choice = card;
@@ -161,7 +161,6 @@ void cribbage_cpu_play(void) {
             // Check for runs
             // Check for cards that make 10, 21, or 5 (and don't play those)
         }
-        card = card->next;
     }
     if(choice) {
         // Made a card choice, lets make sure it's valid
@@ -170,7 +169,7 @@ void cribbage_cpu_play(void) {
     if(!choice || (valuecheck > 31)) {
         choice = get_card_at(cpuhand,i);
         while((cribbage_card_value(choice->flags) + g_cribbage->count) > 31) {
-            i = mt_rand(0,numcards-1);
+            i = rng_range(&g_cribbage->rng,0,numcards-1);
             choice = get_card_at(cpuhand,i);
         }
     }
@@ -184,8 +183,8 @@ void cribbage_update_count(void) {
     Deck *board = g_cribbage->decks[CR_BOARD];
     Card *card = get_last_card(board);
     int score = 0;
-    char *msg = malloc(80*sizeof(char));
-    CribScore *boardscore = NULL;
+    char msg[CR_MSG_SZ];
+    CribScore boardscore;
     msg[0] = '\0';
     // Last card will never break 31 because both players are checked for valid
     // cards before this function is called. Theoretically. I should probably
@@ -195,25 +194,23 @@ void cribbage_update_count(void) {
     // Check 15/31
     if(15 == g_cribbage->count) {
         score += 2;
-        snprintf(msg,80,"15 for %d!", score);
+        snprintf(msg,CR_MSG_SZ,"15 for %d!", score);
     } else if (31 == g_cribbage->count) {
         score += 2;
-        snprintf(msg,80,"31 for 2!");
+        snprintf(msg,CR_MSG_SZ,"31 for 2!");
     }
     // Check boardscore (runs and pairs)
     boardscore = score_cribbage_play(board);
-    if(boardscore) {
-        score += boardscore->pts;
-    }
+    score += boardscore.pts;
     // Add points
     cribbage_add_points(score,g_cribbage->pturn);
     // Format and send cribbage msg
-    if(boardscore) {
+    if(boardscore.pts) {
         // Runs, pairs, and/or 15/31.
-        boardscore->msg[0] = toupper(boardscore->msg[0]);
+        boardscore.msg[0] = toupper(boardscore.msg[0]);
         cribbage_msg("%s: %d. %s %s",
             (g_cribbage->pturn ? "You" : "CPU"),
-            g_cribbage->count, boardscore->msg, msg);
+            g_cribbage->count, boardscore.msg, msg);
     } else if (score) {
         // 15/31
         cribbage_msg("%s: %s",
@@ -225,21 +222,11 @@ void cribbage_update_count(void) {
             (g_cribbage->pturn ? "You" : "CPU"),
             g_cribbage->count);
     }
-    free(msg);
 }
 
 bool cribbage_check_go(Deck *deck) {
-    Card *cards = NULL;
-    int count = g_cribbage->count;
-    cards = deck->cards;
-    if(!cards) return true;
-    while(cards) {
-        if((cribbage_card_value(cards->flags) + count) <= 31) {
-             return false;
-        }
-        cards = cards->next;
-    }
-    return true;
+    // Go if there's nothing in the deck that can be played without passing 31
+    return !(deck->set & cardset_worth_upto(31 - g_cribbage->count));
 }
 
 void cribbage_check_win(void) {
@@ -274,19 +261,18 @@ void cribbage_add_points(int points, bool player) {
     *score += points;
 }
 
-void cribbage_show_points(Card *hand, bool player, char *msg) {
-    CribScore *score = score_cribbage_hand(hand, g_cribbage->decks[CR_STOCK]->cards);
-    cribbage_add_points(score->pts, player);
-    cribbage_msg("%s: %s", msg, score->msg);
-    cribbage_prompt("Press any key to continue...");
-    destroy_cribscore(score);
+void cribbage_show_points(Deck *hand, bool player, char *msg) {
+    CribScore score = score_cribbage_hand(hand,
+            get_last_card(g_cribbage->decks[CR_STOCK]));
+    cribbage_add_points(score.pts, player);
+    cribbage_msg("%s: %s", msg, score.msg);
+    cribbage_prompt(NULL, "Press any key to continue...");
 }
 
-void cribbage_flip_cards(Card *cards) {
-    Card *tmp = cards;
-    while(tmp) {
-        tmp->flags |= CD_UP;
-        tmp = tmp->next;
+void cribbage_flip_cards(Deck *deck) {
+    int i = 0;
+    for(i = 0; i < deck->count; i++) {
+        deck->cards[i]->flags |= CD_UP;
     }
 }
 
@@ -307,9 +293,12 @@ void cribbage_update(void) {
 }
 
 void cribbage_update_win(void) {
+    cribbage_prompt(&cribbage_another_round, "Another round? (y/n):");
+}
+
+void cribbage_another_round(char answer, void *data) {
     int i = 0;
-    char ch = cribbage_prompt("Another round? (y/n):");
-    if(ch == 'Y') {
+    if(answer == 'Y') {
         // Start a new round
         g_cribbage->flags &= ~GFL_CRIBDISC;
         g_cribbage->flags &= ~GFL_CRIBPLAY;
@@ -320,6 +309,7 @@ void cribbage_update_win(void) {
         g_cribbage->cScore = 0;
         g_cribbage->pegC1 = g_cribbage->pegC2 = 0;
         g_cribbage->pegP1 = g_cribbage->pegP2 = 0;
+        g_cribbage->showstep = CR_SHOW_START;
         cribbage_clear_msg();
         for(i = 0; i < 6; i++) {
             g_cribbage->btns[i]->active = true;
@@ -334,9 +324,7 @@ void cribbage_update_win(void) {
 void cribbage_update_discard(void) {
     int i = 0, count = 0;
     int id_a = 0, id_b = 0;
-    char *astr = NULL, *bstr = NULL;
-    Card *acard = NULL, *bcard = NULL;
-    char ch = '\0';
+    const char *astr = NULL, *bstr = NULL;
     // Count how many buttons are selected
     count = 0;
     for(i = 0; i < 6; i++) {
@@ -349,57 +337,65 @@ void cribbage_update_discard(void) {
     // If 2, prompt the user for confirmation that these two are what they want
     // to add to the crib
     if(2 == count) {
+        astr = get_card_str(get_card_at(g_cribbage->decks[CR_PLAYER], id_a));
+        bstr = get_card_str(get_card_at(g_cribbage->decks[CR_PLAYER], id_b));
+        cribbage_prompt(&cribbage_discard_answer,
+                "Add the %s and %s to the crib? [y/n]", astr, bstr);
+    }
+}
+
+void cribbage_discard_answer(char answer, void *data) {
+    // If user confirms, add the two (still selected) cards to the crib and
+    // change state to GFL_CRIBPLAY. If user declines, deselect all buttons
+    int i = 0;
+    int id_a = 0, id_b = 0;
+    Card *acard = NULL, *bcard = NULL;
+    for(i = 0; i < 6; i++) {
+        if(g_cribbage->btns[i]->selected) {
+            (id_a ? (id_b = i) : (id_a = i));
+        }
+    }
+    if('Y' == answer)
+    {
+        // Move cards to crib, change state
         acard = get_card_at(g_cribbage->decks[CR_PLAYER], id_a);
         bcard = get_card_at(g_cribbage->decks[CR_PLAYER], id_b);
-        astr = get_card_str(acard);
-        bstr = get_card_str(bcard);
-        // If user confirms, add the two cards to the crib and change state to
-        // GFL_CRIBPLAY
-        // If user declines, deselect all buttons
-        ch = cribbage_prompt("Add the %s and %s to the crib? [y/n]", astr, bstr);
-        if('Y' == ch)
-        {
-            // Move cards to crib, change state
-            remove_card_from_deck(g_cribbage->decks[CR_PLAYER],acard);
-            add_card_to_deck(g_cribbage->decks[CR_CRIB],acard);
-            remove_card_from_deck(g_cribbage->decks[CR_PLAYER],bcard);
-            add_card_to_deck(g_cribbage->decks[CR_CRIB],bcard);
-
-            cribbage_cpu_to_crib();
-
-            g_cribbage->flags &= ~GFL_CRIBDISC;
-            g_cribbage->flags |= GFL_CRIBPLAY | GFL_DRAW;
-            cribbage_msg("Choose a card to play");
-            for(i = 0; i < 6; i++) {
-                g_cribbage->btns[i]->selected = false;
-                // Deactivate last two buttons, not needed now
-                if(i > 3) {
-                    g_cribbage->btns[i]->active = false;
-                }
-            }
-        } else {
-            for(i = 0; i < 6; i++) {
-                g_cribbage->btns[i]->selected = false;
+        remove_card_from_deck(g_cribbage->decks[CR_PLAYER],acard);
+        add_card_to_deck(g_cribbage->decks[CR_CRIB],acard);
+        remove_card_from_deck(g_cribbage->decks[CR_PLAYER],bcard);
+        add_card_to_deck(g_cribbage->decks[CR_CRIB],bcard);
+
+        cribbage_cpu_to_crib();
+
+        g_cribbage->flags &= ~GFL_CRIBDISC;
+        g_cribbage->flags |= GFL_CRIBPLAY | GFL_DRAW;
+        cribbage_msg("Choose a card to play");
+        for(i = 0; i < 6; i++) {
+            g_cribbage->btns[i]->selected = false;
+            // Deactivate last two buttons, not needed now
+            if(i > 3) {
+                g_cribbage->btns[i]->active = false;
             }
         }
-        g_cribbage->flags |= GFL_DRAW;
+    } else {
+        for(i = 0; i < 6; i++) {
+            g_cribbage->btns[i]->selected = false;
+        }
     }
-    if(astr) free(astr);
-    if(bstr) free(bstr);
+    g_cribbage->flags |= GFL_DRAW;
 }
 
 void cribbage_update_play(void) {
     // Alternate turns playing cards, scoring points and increasing the count
     int i = 0, id = 0, count = 0;
     bool selected = false, player = false;
-    char *msg = NULL;
+    const char *msg = NULL;
     Card *pcard = NULL;
     Deck *pdeck = g_cribbage->decks[CR_PLAYER];
     Deck *cdeck = g_cribbage->decks[CR_CPU];
 
     // Check to see if both player and cpu hands are empty
-    if((count_cards(g_cribbage->decks[CR_PLAYER]->cards) == 0) &&
-            (count_cards(g_cribbage->decks[CR_CPU]->cards) == 0)) {
+    if((count_cards(pdeck) == 0) && (count_cards(cdeck) == 0)) {
         // Award point for last card
         pcard = get_last_card(g_cribbage->decks[CR_BOARD]);
         player = check_flag(pcard->flags, CD_PLAYER);
@@ -407,11 +403,8 @@ void cribbage_update_play(void) {
             cribbage_msg("%s: 1 for last.", (player ? "You" : "CPU"));
             cribbage_add_points(1,player);
         }
-        // Change state
-        cribbage_prompt("Press any key to continue...");
-        g_cribbage->flags &= ~GFL_CRIBPLAY;
-        g_cribbage->flags |= GFL_CRIBSHOW;
-        cribbage_clear_msg();
+        // Change state once the player has seen it
+        cribbage_prompt(&cribbage_play_done, "Press any key to continue...");
         return;
     } 
     // Check to see if both players have a go
@@ -424,26 +417,22 @@ void cribbage_update_play(void) {
             g_cribbage->pturn = !g_cribbage->pturn;
         } else {
             if(g_cribbage->count != 31) {
-                if(count_cards(g_cribbage->decks[CR_PLAYER]->cards)) {
+                if(count_cards(pdeck)) {
                     cribbage_msg("You: Go.");
                 }
-                if(count_cards(g_cribbage->decks[CR_CPU]->cards)) {
+                if(count_cards(cdeck)) {
                     cribbage_msg("CPU: Go.");
                 }
                 cribbage_msg("%s: %d. 1 for last.", (player ? "You" : "CPU"), 
                         g_cribbage->count);
                 cribbage_add_points(1,player);
             }
-            cribbage_prompt("Press any key to continue...");
-            g_cribbage->count = 0;
-            g_cribbage->flags |= GFL_DRAW;
+            // The count is reset after the player has seen it
+            cribbage_prompt(&cribbage_go_answer, "Press any key to continue...");
+            return;
         }
         // Turn all cards in CR_BOARD inactive - CD_UP
-        pcard = g_cribbage->decks[CR_BOARD]->cards;
-        while(pcard) {
-            pcard->flags |= CD_UP;
-            pcard = pcard->next;
-        }
+        cribbage_flip_cards(g_cribbage->decks[CR_BOARD]);
         return;
     }
 
@@ -452,9 +441,7 @@ void cribbage_update_play(void) {
         //Check if player has a go
         if(cribbage_check_go(pdeck)) {
             //cribbage_msg("You: Go.");
-            cribbage_prompt("You: Go. (Press any key)");
-            g_cribbage->pturn = false;
-            g_cribbage->flags |= GFL_DRAW;
+            cribbage_prompt(&cribbage_player_go, "You: Go. (Press any key)");
             return;
         }
 
@@ -484,7 +471,6 @@ void cribbage_update_play(void) {
                 } else {
                     msg = get_card_str(pcard);
                     cribbage_msg("You can't play the %s, try again.",msg);
-                    if(msg) free(msg);
                 }
             }
             for(i = 0; i < 6; i++) {
@@ -493,86 +479,130 @@ void cribbage_update_play(void) {
             g_cribbage->flags |= GFL_DRAW;
         }
     } else if(!check_flag(g_cribbage->flags, GFL_WIN)){
-        // Have the computer play a card
-        g_cribbage->flags |= GFL_DRAW;
-        if(cribbage_check_go(cdeck)) {
-            cribbage_msg("CPU: Go.");
-            //cribbage_prompt("CPU: Go. (Press any key)");
-        } else {
-            cribbage_cpu_play();
-            cribbage_update_count();
+        // Have the computer play a card - after a short wait, so the player
+        // gets to see their own card hit the table first. If the timer can't
+        // be set for some reason, just play right away.
+        if(g_cribbage->cputimer == -1) {
+            g_cribbage->cputimer = game_loop_after(g_cribbage->loop,
+                    CR_CPU_DELAY, &cribbage_cpu_turn, NULL);
+            if(g_cribbage->cputimer == -1) {
+                cribbage_cpu_turn(NULL);
+            }
         }
-        g_cribbage->pturn = true;
+        return;
     }
 
     //Check win condition
     cribbage_check_win();
 }
 
+void cribbage_play_done(char answer, void *data) {
+    // Both hands are played out, on to the show
+    g_cribbage->flags &= ~GFL_CRIBPLAY;
+    g_cribbage->flags |= GFL_CRIBSHOW;
+    cribbage_clear_msg();
+}
+
+void cribbage_go_answer(char answer, void *data) {
+    // Both players said go, start the count over
+    g_cribbage->count = 0;
+    g_cribbage->flags |= GFL_DRAW;
+    // Turn all cards in CR_BOARD inactive - CD_UP
+    cribbage_flip_cards(g_cribbage->decks[CR_BOARD]);
+}
+
+void cribbage_player_go(char answer, void *data) {
+    g_cribbage->pturn = false;
+    g_cribbage->flags |= GFL_DRAW;
+}
+
+void cribbage_cpu_turn(void *data) {
+    // The computer's turn during the play, set off by a timer from
+    // cribbage_update_play()
+    Deck *cdeck = g_cribbage->decks[CR_CPU];
+    g_cribbage->cputimer = -1;
+    // If the player is busy with a prompt, update will set the timer again
+    // once they're done
+    if(g_cribbage->loop->prompt.active) return;
+    if(!check_flag(g_cribbage->flags, GFL_CRIBPLAY)) return;
+    if(check_flag(g_cribbage->flags, GFL_WIN) || g_cribbage->pturn) return;
+    g_cribbage->flags |= GFL_DRAW;
+    if(cribbage_check_go(cdeck)) {
+        cribbage_msg("CPU: Go.");
+        //cribbage_prompt("CPU: Go. (Press any key)");
+    } else {
+        cribbage_cpu_play();
+        cribbage_update_count();
+    }
+    g_cribbage->pturn = true;
+    cribbage_check_win();
+}
+
+void cribbage_show_hand(bool player) {
+    // Turn over and score the player's (or cpu's) hand
+    Deck *hand = g_cribbage->decks[player ? CR_PLAYER : CR_CPU];
+    cribbage_flip_cards(hand);
+    cribbage_show_points(hand, player, (player ? "Your hand" : "CPU hand"));
+}
+
 void cribbage_update_show(void) {
-    // Score hands
+    /* Score hands. Every hand that's scored waits on a "press any key"
+     * prompt, so this works through the show one step at a time - update is
+     * called again for the next step once the prompt has been answered. The
+     * hand without the crib is counted first, then the hand with the crib,
+     * then the crib itself. */
     Card *pcard = NULL;
     int i = 0;
 
-    pcard = g_cribbage->decks[CR_BOARD]->cards;
-    if(pcard) {
-        //Move cards from the board back to the hand
-        while(pcard) {
-            remove_card_from_deck(g_cribbage->decks[CR_BOARD],pcard);
-            pcard->flags &= ~CD_UP;
-            if(check_flag(pcard->flags, CD_PLAYER)) {
-                add_card_to_deck(g_cribbage->decks[CR_PLAYER],pcard);
-            } else {
-                add_card_to_deck(g_cribbage->decks[CR_CPU],pcard);
+    switch(g_cribbage->showstep) {
+        case CR_SHOW_START:
+            //Move cards from the board back to the hand
+            while(g_cribbage->decks[CR_BOARD]->count) {
+                pcard = remove_card_at(g_cribbage->decks[CR_BOARD],0);
+                pcard->flags &= ~CD_UP;
+                if(check_flag(pcard->flags, CD_PLAYER)) {
+                    add_card_to_deck(g_cribbage->decks[CR_PLAYER],pcard);
+                } else {
+                    add_card_to_deck(g_cribbage->decks[CR_CPU],pcard);
+                }
             }
-            pcard = g_cribbage->decks[CR_BOARD]->cards;
-        }
-        merge_sort_deck(g_cribbage->decks[CR_PLAYER]);
-        merge_sort_deck(g_cribbage->decks[CR_CPU]);
-        merge_sort_deck(g_cribbage->decks[CR_CRIB]);
-
-        // Award points
-        if(g_cribbage->pcrib) {
-            //Computer
-            cribbage_flip_cards(g_cribbage->decks[CR_CPU]->cards);
-            cribbage_show_points(g_cribbage->decks[CR_CPU]->cards, false, "CPU hand");
+            sort_deck(g_cribbage->decks[CR_PLAYER]);
+            sort_deck(g_cribbage->decks[CR_CPU]);
+            sort_deck(g_cribbage->decks[CR_CRIB]);
+
+            g_cribbage->showstep = CR_SHOW_FIRST;
+            cribbage_show_hand(!g_cribbage->pcrib);
+            break;
+        case CR_SHOW_FIRST:
             cribbage_check_win();
-            if(!check_flag(g_cribbage->flags, GFL_WIN)) {
-                //Player (TODO: make player state points first/instead)
-                cribbage_flip_cards(g_cribbage->decks[CR_PLAYER]->cards);
-                cribbage_show_points(g_cribbage->decks[CR_PLAYER]->cards, true, "Your hand");
-                cribbage_check_win();
-            }
-        } else {
-            //Player
-            cribbage_flip_cards(g_cribbage->decks[CR_PLAYER]->cards);
-            cribbage_show_points(g_cribbage->decks[CR_PLAYER]->cards, true, "Your hand");
+            if(check_flag(g_cribbage->flags, GFL_WIN)) break;
+            g_cribbage->showstep = CR_SHOW_SECOND;
+            cribbage_show_hand(g_cribbage->pcrib);
+            break;
+        case CR_SHOW_SECOND:
             cribbage_check_win();
-            //Computer
-            if(!check_flag(g_cribbage->flags, GFL_WIN)) {
-                cribbage_flip_cards(g_cribbage->decks[CR_CPU]->cards);
-                cribbage_show_points(g_cribbage->decks[CR_CPU]->cards, false, "CPU hand");
-                cribbage_check_win();
-            }
-        }
-        //Crib
-        if(!check_flag(g_cribbage->flags, GFL_WIN)) {
-            cribbage_flip_cards(g_cribbage->decks[CR_CRIB]->cards);
-            cribbage_show_points(g_cribbage->decks[CR_CRIB]->cards, g_cribbage->pcrib,
+            if(check_flag(g_cribbage->flags, GFL_WIN)) break;
+            //Crib
+            g_cribbage->showstep = CR_SHOW_CRIB;
+            cribbage_flip_cards(g_cribbage->decks[CR_CRIB]);
+            cribbage_show_points(g_cribbage->decks[CR_CRIB], g_cribbage->pcrib,
                     (g_cribbage->pcrib ? "Your crib" : "CPU's Crib"));
+            break;
+        case CR_SHOW_CRIB:
+        default:
             cribbage_check_win();
-        }
-
-        if(!check_flag(g_cribbage->flags, GFL_WIN)) {
+            if(check_flag(g_cribbage->flags, GFL_WIN)) break;
             // Move to next round
             cribbage_clear_msg();
             for(i = 0; i < 6; i++) {
                 g_cribbage->btns[i]->active = true;
             }
             g_cribbage->count = 0;
+            g_cribbage->showstep = CR_SHOW_START;
             g_cribbage->flags &= ~GFL_CRIBSHOW;
             cribbage_deal();
-        }
+            break;
     }
+    g_cribbage->flags |= GFL_DRAW;
 }
 
@@ -29,91 +29,64 @@
  */
 
 int cribbage_card_value(int card) {
-    int result = get_rank(card);
-    if(result > 10) {
-        return 10;
-    } else {
-        return result;
-    }
+    int id = card_id(card);
+    if(id < 0) return 0;
+    return g_cardtab.value[id];
 }
 
-CribScore* create_cribscore(int qty, int pts, char *msg,...) {
-    CribScore *score = malloc(sizeof(CribScore));
+CribScore make_cribscore(int qty, int pts, char *msg,...) {
+    // Scores are small enough to hand around by value, the message included,
+    // so nothing here needs to be malloc'd or freed.
+    CribScore score;
     va_list args;
+    score.qty = qty;
+    score.pts = pts;
+    score.msg[0] = '\0';
+    if(!msg) return score;
     va_start(args, msg);
-    score->qty = qty;
-    score->pts = pts;
-    score->msg = malloc(80 * sizeof(char));
-    vsnprintf(score->msg, 80, msg, args);
+    vsnprintf(score.msg, CR_MSG_SZ, msg, args);
+    va_end(args);
     return score;
 }
 
-void destroy_cribscore(CribScore *score) {
-    if(!score) return;
-    if(score->msg) {
-        free(score->msg);
-        score->msg = NULL;
-    }
-    free(score);
-    score = NULL;
+static void append_cribscore(char *buf, char *sep, CribScore *score) {
+    // Tack score's message onto the end of buf (CR_MSG_SZ long), with sep
+    // in between if buf already has something in it.
+    size_t n = strlen(buf);
+    if(!score->pts) return;
+    snprintf(buf + n, CR_MSG_SZ - n, "%s%s", (n ? sep : ""), score->msg);
 }
 
-CribScore* score_cribbage_hand(Card *hand, Card *flop) {
-    char *buf = malloc(80 * sizeof(char));
-    buf[0] = '\0'; 
+CribScore score_cribbage_hand(Deck *hand, Card *flop) {
+    char buf[CR_MSG_SZ];
     int score = 0;
-    CribScore *fifteens = count_15s(hand, flop);
-    CribScore *runs = count_runs(hand, flop);
-    CribScore *pairs = count_pairs(hand,flop);
-    CribScore *flush = count_flush(hand,flop);
-    CribScore *nobs = count_nobs(hand,flop);
-    CribScore *result = NULL;
-    if(fifteens) {
-        score += fifteens->pts;
-        strcat(buf, fifteens->msg);
-    }
-    if(runs) {
-        score += runs->pts;
-        if(buf[0] != '\0') strcat(buf, ", ");
-        strcat(buf, runs->msg);
-    }
-    if(pairs) {
-        score += pairs->pts;
-        if(buf[0] != '\0') strcat(buf, ", ");
-        strcat(buf, pairs->msg);
-    }
-    if(flush) {
-        /*Need to remember to add something to check if this is the crib...
-         * since we need all 5 cards to be the same for a flush to count in the
-         * crib */
-        score += flush->pts;
-        if(buf[0] != '\0') strcat(buf, ", ");
-        strcat(buf, flush->msg);
-    }
-    if(nobs) {
-        score += nobs->pts;
-        if(buf[0] != '\0') strcat(buf, ", and ");
-        strcat(buf, nobs->msg);
-    }
+    CribScore fifteens = count_15s(hand, flop);
+    CribScore runs = count_runs(hand, flop);
+    CribScore pairs = count_pairs(hand,flop);
+    CribScore flush = count_flush(hand,flop);
+    CribScore nobs = count_nobs(hand,flop);
+    buf[0] = '\0'; 
+    /*Need to remember to add something to check if this is the crib...
+     * since we need all 5 cards to be the same for a flush to count in the
+     * crib */
+    score = fifteens.pts + runs.pts + pairs.pts + flush.pts + nobs.pts;
+    append_cribscore(buf, "", &fifteens);
+    append_cribscore(buf, ", ", &runs);
+    append_cribscore(buf, ", ", &pairs);
+    append_cribscore(buf, ", ", &flush);
+    append_cribscore(buf, ", and ", &nobs);
+    // The longest breakdown any hand can get is 66 characters ("Three 15s for
+    // 6, double run of 3 for 6, pair for 2, and nobs for 1"), so it still fits
+    // in one CR_MSG_SZ line after "CPU's Crib: " - keep the pieces short.
     if(score) {
         //scr_pt(0, g_screenH - 3, "%s - %d points!", buf, score);
-        //snprintf(msg,80,"%s - %d points.",buf,score);
         buf[0] = toupper(buf[0]);
-        result = create_cribscore(0,score,"%s",buf,score);
-    } else {
-        //snprintf(msg,80,"No points.");
-        result = create_cribscore(0,0,"No points!");
+        return make_cribscore(0,score,"%s",buf);
     }
-    destroy_cribscore(fifteens);
-    destroy_cribscore(runs);
-    destroy_cribscore(pairs);
-    destroy_cribscore(flush);
-    destroy_cribscore(nobs);
-    free(buf);
-    return result;
+    return make_cribscore(0,0,"No points!");
 }
 
-CribScore* score_cribbage_play(Deck *deck) {
+CribScore score_cribbage_play(Deck *deck) {
     /*
      * Need to look through the ACTIVE cards in the deck for:
      *  - Runs
@@ -121,11 +94,12 @@ CribScore* score_cribbage_play(Deck *deck) {
      * Unlike the other cribscore functions, the order of the cards matters - a
      * run only counts if it is in an unbroken sequence. 
      */
-    if(!deck) return NULL;
-    CribScore *result = NULL;
+    CribScore result = make_cribscore(0,0,NULL);
+    if(!deck) return result;
     Card *card = get_last_card(deck);
     Card *tmp = NULL;
     int i = 0, j = 0;
+    int n = deck->count - 2; // The card played before the last card
     int p = 0; // 'p'air counters
     int cr = get_rank(card->flags); //current rank
     int lr = cr; //lowest rank
@@ -134,46 +108,45 @@ CribScore* score_cribbage_play(Deck *deck) {
     bool seenRanks[14] = {false}; // Ranks start at 1, not 0, so 14 for 13 ranks.
     seenRanks[cr] = true;
     int score = 0;
-    char *buf = malloc(80*sizeof(char));
-    buf[0] = '\0';
+    char *buf = "";
     // Look for pairs
-    if(card->prev) {
-        tmp = card->prev;
-        while(tmp && card_same_rank(tmp->flags, card->flags) && !check_flag(tmp->flags, CD_UP)) {
-            // Loop backwards through cards, incrementing counter while there
-            // still is a previous card AND it has the same rank as the current
-            // card AND its an active card
-            p += 1;    
-            tmp = tmp->prev;
-        }
+    for(i = n; i >= 0; i--) {
+        // Loop backwards through cards, incrementing counter while there
+        // still is a previous card AND it has the same rank as the current
+        // card AND its an active card
+        tmp = deck->cards[i];
+        if(!card_same_rank(tmp->flags, card->flags)) break;
+        if(check_flag(tmp->flags, CD_UP)) break;
+        p += 1;    
     }
 
     if(p != 0) {
         switch(p) {
             case(1):
                 score = 2; 
-                snprintf(buf,80,"pair");
+                buf = "pair";
                 break;
             case(2): 
                 score = 6; 
-                snprintf(buf,80,"three of a kind");
+                buf = "three of a kind";
                 break;
             case(3): 
                 score = 12; 
-                snprintf(buf,80,"four of a kind");
+                buf = "four of a kind";
                 break;
             default: 
                 score = 0; 
                 break;
         }
-        result = create_cribscore(1,score, "%s for %d!",buf,score);
+        result = make_cribscore(1,score, "%s for %d!",buf,score);
     }
     // Check for runs
-    if(count_cards(deck->cards) > 2) {
+    if(deck->count > 2) {
         // Loop backwards through cards on table, starting before the last card
         // played
-        tmp = card->prev;
-        while(tmp && !check_flag(tmp->flags, CD_UP)) {
+        for(i = n; i >= 0; i--) {
+            tmp = deck->cards[i];
+            if(check_flag(tmp->flags, CD_UP)) break;
             j = get_rank(tmp->flags);
             if(seenRanks[j]) break; // If we hit a pair, it's not a sequence
             seenRanks[j] = true; // Flip the current rank to true
@@ -185,41 +158,36 @@ CribScore* score_cribbage_play(Deck *deck) {
             if(j > hr) {
                 hr = j;
             }
-            // Starting at the lowest rank, going to highest, increment i
-            for(i = lr; i <= hr; i++) {
-                if(!seenRanks[i]) break; // break when we've seen rank i
+            // Starting at the lowest rank, going to highest, increment j
+            for(j = lr; j <= hr; j++) {
+                if(!seenRanks[j]) break; // break when we've seen rank j
             }
-            // If i is greater than the highest rank, update the longest
+            // If j is greater than the highest rank, update the longest
             // sequence. This only happens if everything from lowest to highest
             // is in sequence.
-            if(i > hr) {
+            if(j > hr) {
                 // longest = highest rank - lowest rank + 1 (for the last card
                 // played)
                 ls = hr - lr + 1;
             }
-            tmp = tmp->prev;
         }
         if(ls > 2) {
-            if(result) destroy_cribscore(result);
-            result = create_cribscore(1,ls,"run of %d!", ls);
+            result = make_cribscore(1,ls,"run of %d!", ls);
         }
     }
-    free(buf);
     return result;
 }
 
-CribScore* count_runs(Card *hand, Card *flop) {
-    if(!hand) return NULL;
-    if(!flop) return NULL;
-    if(count_cards(hand) != 4) return NULL;
-    CribScore *result = NULL;
+CribScore count_runs(Deck *hand, Card *flop) {
+    CribScore result = make_cribscore(0,0,NULL);
+    if(!hand || !flop || (hand->count != 4)) return result;
     uint8_t matrix[13] = { 0 }; // 13 cards (x) in each of the 4 suites (y), and 1 to total the matrix (y)
     int x,y,cur,prev,r,m,br,bm; // r/br: run/best run. m/bm: multiplier/best multiplier
     int cards[5]; //Shortcut to hold the card flags (smart)
-    cards[0] = hand->flags;
-    cards[1] = hand->next->flags;
-    cards[2] = hand->next->next->flags;
-    cards[3] = hand->next->next->next->flags;
+    cards[0] = hand->cards[0]->flags;
+    cards[1] = hand->cards[1]->flags;
+    cards[2] = hand->cards[2]->flags;
+    cards[3] = hand->cards[3]->flags;
     cards[4] = flop->flags;
     /*
     //Original 2022 matrix code, leaving it here for ... well so I remember what
@@ -312,19 +280,19 @@ CribScore* count_runs(Card *hand, Card *flop) {
     if(br >= 3) {
         switch(bm) {
             case 1:
-                result = create_cribscore(1, br, "a run of %d for %d", br,br);
+                result = make_cribscore(1, br, "run of %d for %d", br,br);
                 break;
             case 2:
-                result = create_cribscore(bm, br*bm, 
-                        "a double run of %d for %d", br,br*bm);
+                result = make_cribscore(bm, br*bm, 
+                        "double run of %d for %d", br,br*bm);
                 break;
             case 3:
-                result = create_cribscore(bm, br*bm, 
-                        "a triple run of %d for %d", br,br*bm);
+                result = make_cribscore(bm, br*bm, 
+                        "triple run of %d for %d", br,br*bm);
                 break;
             case 4:
-                result = create_cribscore(bm, br*bm,
-                        "a quadruple run of %d for %d",br,br*bm);
+                result = make_cribscore(bm, br*bm,
+                        "quadruple run of %d for %d",br,br*bm);
                 break;
             default: break;
         }
@@ -332,16 +300,14 @@ CribScore* count_runs(Card *hand, Card *flop) {
     return result;
 }
 
-CribScore* count_flush(Card *hand, Card *flop) {
-    if(!hand) return 0;
-    if(!flop) return 0;
-    if(count_cards(hand) != 4) return 0;
-    CribScore *result = NULL;
+CribScore count_flush(Deck *hand, Card *flop) {
+    CribScore result = make_cribscore(0,0,NULL);
+    if(!hand || !flop || (hand->count != 4)) return result;
     int cards[5];
-    cards[0] = hand->flags;
-    cards[1] = hand->next->flags;
-    cards[2] = hand->next->next->flags;
-    cards[3] = hand->next->next->next->flags;
+    cards[0] = hand->cards[0]->flags;
+    cards[1] = hand->cards[1]->flags;
+    cards[2] = hand->cards[2]->flags;
+    cards[3] = hand->cards[3]->flags;
     cards[4] = flop->flags;
     uint8_t matrix[4][5] = {{ 0 }};
     int x,y,n;
@@ -358,46 +324,42 @@ CribScore* count_flush(Card *hand, Card *flop) {
     }
     if(n == 4) {
         if(card_same_suite(cards[4],cards[0])) {
-            result = create_cribscore(1,5, "flush for 5");
+            result = make_cribscore(1,5, "flush for 5");
         } else {
-            result = create_cribscore(1,4, "flush for 4");
+            result = make_cribscore(1,4, "flush for 4");
         }
     }
 
     return result;
 }
 
-CribScore* count_nobs(Card *hand, Card *flop) {
-    if(!hand) return 0;
-    if(!flop) return 0;
-    if(count_cards(hand) != 4) return 0;
-    CribScore *result = NULL;
+CribScore count_nobs(Deck *hand, Card *flop) {
+    CribScore result = make_cribscore(0,0,NULL);
+    if(!hand || !flop || (hand->count != 4)) return result;
     int i = 0;
-    int A = hand->flags;
-    int B = hand->next->flags;
-    int C = hand->next->next->flags;
-    int D = hand->next->next->next->flags;
+    int A = hand->cards[0]->flags;
+    int B = hand->cards[1]->flags;
+    int C = hand->cards[2]->flags;
+    int D = hand->cards[3]->flags;
     int E = flop->flags;
     if(((A & CD_J) == CD_J) && (card_same_suite(E,A))) i++;
     if(((B & CD_J) == CD_J) && (card_same_suite(E,B))) i++;
     if(((C & CD_J) == CD_J) && (card_same_suite(E,C))) i++;
     if(((D & CD_J) == CD_J) && (card_same_suite(E,D))) i++;
     if(i) {
-        result = create_cribscore(1, 1, "one for his nobs!");
+        result = make_cribscore(1, 1, "nobs for 1");
     }
     return result;
 }
 
-CribScore* count_pairs(Card *hand, Card *flop) {
-    if(!hand) return 0;
-    if(!flop) return 0;
-    if(count_cards(hand) != 4) return 0;
-    CribScore *result = NULL;
+CribScore count_pairs(Deck *hand, Card *flop) {
+    CribScore result = make_cribscore(0,0,NULL);
+    if(!hand || !flop || (hand->count != 4)) return result;
     int i = 0;
-    int A = get_rank(hand->flags);
-    int B = get_rank(hand->next->flags);
-    int C = get_rank(hand->next->next->flags);
-    int D = get_rank(hand->next->next->next->flags);
+    int A = get_rank(hand->cards[0]->flags);
+    int B = get_rank(hand->cards[1]->flags);
+    int C = get_rank(hand->cards[2]->flags);
+    int D = get_rank(hand->cards[3]->flags);
     int E = get_rank(flop->flags);
     if(A == B) i++;
     if(A == C) i++;
@@ -410,31 +372,30 @@ CribScore* count_pairs(Card *hand, Card *flop) {
     if(C == E) i++;
     if(D == E) i++;
     if(i == 1) {
-        result = create_cribscore(1, 2, "pair for 2");
+        result = make_cribscore(1, 2, "pair for 2");
     } else if(i == 2) {
-        result = create_cribscore(2, 4, "two pairs for 4");
+        result = make_cribscore(2, 4, "two pairs for 4");
     } else if(i == 3) {
-        result = create_cribscore(3, 6, "a pair royale for 6");
+        result = make_cribscore(3, 6, "pair royale for 6");
     } else if(i == 6) {
-        result = create_cribscore(6, 12, "a double pair royale for 12");
+        result = make_cribscore(6, 12, "double pair royale for 12");
     } else if (i) {
-        result = create_cribscore(i,i*2,"%d pairs for %d", i, i*2);
+        result = make_cribscore(i,i*2,"%d pairs for %d", i, i*2);
     }
     return result;
 }
 
 
-CribScore* count_15s(Card *hand, Card *flop) {
-    if(!hand) return 0;
-    if(!flop) return 0;
-    if(count_cards(hand) != 4) return 0;
-    CribScore *result = NULL;
-    char *num = malloc(80*sizeof(char));
+CribScore count_15s(Deck *hand, Card *flop) {
+    CribScore result = make_cribscore(0,0,NULL);
+    if(!hand || !flop || (hand->count != 4)) return result;
+    const char *num[9] = {"", "one", "two", "three", "four", "five", "six",
+        "seven", "eight"};
     int i = 0;
-    int A = cribbage_card_value(hand->flags);
-    int B = cribbage_card_value(hand->next->flags);
-    int C = cribbage_card_value(hand->next->next->flags);
-    int D = cribbage_card_value(hand->next->next->next->flags);
+    int A = cribbage_card_value(hand->cards[0]->flags);
+    int B = cribbage_card_value(hand->cards[1]->flags);
+    int C = cribbage_card_value(hand->cards[2]->flags);
+    int D = cribbage_card_value(hand->cards[3]->flags);
     int E = cribbage_card_value(flop->flags);
     // Two cards
     if(A+B == 15) i++;
@@ -468,39 +429,10 @@ CribScore* count_15s(Card *hand, Card *flop) {
     if(A+B+C+D+E == 15) i++;
     
     // Highest possible number of 15s in a single hand is eight
-    switch(i) {
-        case(1):
-            snprintf(num,80,"one");
-            break;
-        case(2):
-            snprintf(num,80,"two");
-            break;
-        case(3):
-            snprintf(num,80,"three");
-            break;
-        case(4):
-            snprintf(num,80,"four");
-            break;
-        case(5):
-            snprintf(num,80,"five");
-            break;
-        case(6):
-            snprintf(num,80,"six");
-            break;
-        case(7):
-            snprintf(num,80,"seven");
-            break;
-        case(8):
-            snprintf(num,80,"eight");
-            break;
-        default:
-            break;
-    }
     if(i == 1) {
-        result = create_cribscore(1, 2, "15 for 2");
+        result = make_cribscore(1, 2, "15 for 2");
     } else if (i) {
-        result = create_cribscore(i, i*2, "%s 15s for %d", num, i*2);
+        result = make_cribscore(i, i*2, "%s 15s for %d", num[i], i*2);
     }
-    free(num);
     return result;
 }
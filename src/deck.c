@@ -18,224 +18,403 @@
 * along with Cards.  If not, see <http://www.gnu.org/licenses/>.
 */
 #include <cards.h>
-
-Card* create_card(int cflags) {
-    Card *card = malloc(sizeof(Card));
+#include <ctype.h>
+#include <errno.h>
+
+Card* create_card_in(Arena *arena, int cflags) {
+    /* A card out of arena - it goes away when the arena is reset, there's
+     * nothing to free */
+    Card *card = arena_alloc(arena, sizeof(Card));
+    if(!card) return NULL;
     card->flags = cflags;
-    card->next = NULL;
-    card->prev = NULL;
+    card->serial = card_id(cflags);
     return card;
 }
 
-void destroy_card(Card *card) {
-    if(!card) return;
-    free(card);
+int count_cards(Deck *deck) {
+    if(!deck) return 0;
+    return deck->count;
+}
+
+static void init_deck(Deck *deck, int cap) {
+    deck->set = 0;
+    deck->count = 0;
+    deck->cap = cap;
+    deck->id = 0;
+    memset(deck->copies, 0, CARD_IDS);
 }
 
-int count_cards(Card *card) {
-    if(!card) return 0;
-    return (1 + count_cards(card->next));
+size_t deck_size_for(int cap) {
+    // Bytes needed for a deck with room for cap cards
+    return sizeof(Deck) + (cap * sizeof(Card*));
 }
 
-Deck* create_deck(void) {
-    Deck *result = malloc(sizeof(Deck));
-    result->cards = NULL;
-    result->count = 0;
-    result->id = 0;
+Deck* create_deck_in(Arena *arena, int cap) {
+    /* An empty deck out of arena with room for cap cards (up to PILE_MAX),
+     * see create_card_in() */
+    Deck *result = NULL;
+    if(cap > PILE_MAX) cap = PILE_MAX;
+    result = arena_alloc(arena, deck_size_for(cap));
+    if(!result) return NULL;
+    init_deck(result, cap);
     return result;
 }
 
-void destroy_deck(Deck *deck) {
-    Card *tmp = NULL;
-    while(deck->cards) {
-        tmp = deck->cards;
-        deck->cards = deck->cards->next;
-        destroy_card(tmp);
-    }
-    free(deck);
+static void deck_note_in(Deck *deck, Card *card) {
+    // Count a card that just went into deck in its set
+    int id = card_id(card->flags);
+    if(id < 0) return;
+    if(!deck->copies[id]) deck->set |= (CardSet)1 << id;
+    deck->copies[id] += 1;
+}
+
+static void deck_note_out(Deck *deck, Card *card) {
+    // And one that just came out
+    int id = card_id(card->flags);
+    if((id < 0) || !deck->copies[id]) return;
+    deck->copies[id] -= 1;
+    if(!deck->copies[id]) deck->set &= ~((CardSet)1 << id);
 }
 
 void add_card_to_deck(Deck *deck, Card *card) {
+    // New cards go on the end
     if(!deck || !card) return;
-    Card *tmp = deck->cards;
-    if(!tmp) {
-        // Deck has no cards this card is the first. 
-        deck->cards = card;
-    } else {
-        // Find the last card, and then make it's next card the new card
-        while(tmp->next) {
-            tmp = tmp->next;
-        }
-        card->prev = tmp;
-        tmp->next = card;
-    }
+    if(deck->count >= deck->cap) return; // Can't happen, piles fit the shoe
+    deck->cards[deck->count] = card;
     deck->count += 1;
+    deck_note_in(deck, card);
 }
 
-Card* remove_card_from_deck(Deck *deck, Card *card) {
-    if(!deck || !card) return NULL;
-    if(!deck->cards) return NULL;
-    Card *result = deck->cards;
-    Card *prev = NULL;
-    if(result == card) {
-        deck->cards = deck->cards->next;
-        result->next = NULL;
-        result->prev = NULL;
-    } else {
-        while(result != card && result) {
-            prev = result;
-            result = result->next;
-        }
-        if(result) {
-            prev->next = result->next;
-            if(result->next) {
-                result->next->prev = prev;
-            }
-            result->next = NULL;
-            result->prev = NULL;
-        }
+int find_card_in_deck(Deck *deck, Card *card) {
+    // Index of card in deck, or -1 if it isn't there
+    int i = 0;
+    if(!deck || !card) return -1;
+    for(i = deck->count - 1; i >= 0; i--) {
+        if(deck->cards[i] == card) return i;
     }
+    return -1;
+}
+
+Card* remove_card_at(Deck *deck, int n) {
+    // Take the card at n out of the deck, sliding everything after it down one
+    Card *result = NULL;
+    if(!deck) return NULL;
+    if((n < 0) || (n >= deck->count)) return NULL;
+    result = deck->cards[n];
+    deck_note_out(deck, result);
     deck->count -= 1;
+    if(n < deck->count) {
+        memmove(&deck->cards[n], &deck->cards[n + 1],
+                (deck->count - n) * sizeof(Card*));
+    }
     return result;
 }
 
+Card* remove_card_from_deck(Deck *deck, Card *card) {
+    return remove_card_at(deck, find_card_in_deck(deck, card));
+}
+
+Card* pop_card(Deck *deck) {
+    // Take the last card off the deck
+    if(!deck || !deck->count) return NULL;
+    deck->count -= 1;
+    deck_note_out(deck, deck->cards[deck->count]);
+    return deck->cards[deck->count];
+}
+
 void draw_card(Deck *from, Deck *to) {
+    // The top (last) card of from goes on the end of to
     if(!from || !to) return;
-    if(!from->cards) return;
-    Card *topcard = from->cards;
-    add_card_to_deck(to, remove_card_from_deck(from,topcard));
+    if(!from->count) return;
+    if(to->count >= to->cap) return;
+    add_card_to_deck(to, pop_card(from));
 }
 
 void draw_cards(Deck *from, Deck *to, int n) {
+    /* Draw n cards off the top of from one at a time, so the top card ends up
+     * under the rest (drawing three from the stock leaves the third card on
+     * top of the waste). That's a reversed splice off the end of from, so
+     * doing it again the other way (to back to from) puts them back. */
     if(!from || !to) return;
-    if(!from->cards) return;
-    int i = 0;
-    for(i = 0; i < n; i++) {
-        draw_card(from, to);
-    }
+    if(n > from->count) n = from->count;
+    if(n <= 0) return;
+    splice_cards(from, from->count - n, to, true);
 }
 
 void add_deck(Deck *from, Deck *to) {
     if(!from || !to) return;
-    while(from->cards) {
-        draw_card(from,to);
-    }
+    draw_cards(from, to, from->count);
 }
 
-void fill_deck(Deck *deck) {
+void fill_deck_in(Deck *deck, Arena *arena) {
+    // A standard deck of 52, in rank order, with the cards coming out of arena
     int n = 1;
     for(n = 1; n <= 13; n++) {
-        add_card_to_deck(deck, create_card(get_card(n, 'h')));
-        add_card_to_deck(deck, create_card(get_card(n, 'c')));
-        add_card_to_deck(deck, create_card(get_card(n, 'd')));
-        add_card_to_deck(deck, create_card(get_card(n, 's')));
+        add_card_to_deck(deck, create_card_in(arena, get_card(n, 'h')));
+        add_card_to_deck(deck, create_card_in(arena, get_card(n, 'c')));
+        add_card_to_deck(deck, create_card_in(arena, get_card(n, 'd')));
+        add_card_to_deck(deck, create_card_in(arena, get_card(n, 's')));
     }
 }
 
-Card* search_cards(Card *cards, int cflags) {
-    if(!cards) return NULL;
-    Card *result = cards;
-    while(result) {
-        if(check_flag(result->flags,cflags)) {
-            break;
+/*****
+ * Shoe functions
+ *****/
+size_t shoe_size_for(int decks) {
+    // Room needed in an arena for a shoe of decks decks
+    return arena_size_for(sizeof(Shoe), 1) +
+        arena_size_for(sizeof(Card) * DECK_CARDS * decks, 1);
+}
+
+Shoe* create_shoe_in(Arena *arena, int decks) {
+    /* Make all the cards for decks standard decks (1 to SHOE_MAX_DECKS) out of
+     * arena. They're made in the same order as fill_deck_in(), and card i gets
+     * serial i. */
+    Shoe *shoe = NULL;
+    Card *card = NULL;
+    int i = 0, n = 0, d = 0;
+    const char *suites = "hcds";
+    if(decks < 1) decks = 1;
+    if(decks > SHOE_MAX_DECKS) decks = SHOE_MAX_DECKS;
+    shoe = arena_alloc(arena, sizeof(Shoe));
+    if(!shoe) return NULL;
+    shoe->cards = arena_alloc(arena, sizeof(Card) * DECK_CARDS * decks);
+    if(!shoe->cards) return NULL;
+    shoe->decks = decks;
+    shoe->size = DECK_CARDS * decks;
+    for(d = 0; d < decks; d++) {
+        for(n = 1; n <= 13; n++) {
+            for(i = 0; i < 4; i++) {
+                card = &shoe->cards[(d * DECK_CARDS) + ((n - 1) * 4) + i];
+                card->flags = get_card(n, suites[i]);
+                card->serial = card - shoe->cards;
+            }
         }
-        result = result->next;
     }
-    return result;
+    return shoe;
+}
+
+void fill_deck_from_shoe(Deck *deck, Shoe *shoe) {
+    // Put every card in the shoe in deck, in shoe order
+    int i = 0;
+    if(!deck || !shoe) return;
+    for(i = 0; i < shoe->size; i++) {
+        add_card_to_deck(deck, &shoe->cards[i]);
+    }
 }
 
 Card* search_deck(Deck *deck, int cflags) {
+    int i = 0;
     if(!deck) return NULL;
-    if(!deck->cards) return NULL;
-    Card *result = deck->cards;
-    //while(!check_flag(result->flags, cflags)) {
-    while(result) {
-        if(check_flag(result->flags,cflags)) {
+    if(!(cflags & ~(CD_RANKS | CD_SUITES)) && !(deck->set & cardset_of(cflags))) {
+        // Only looking for a rank/suite, and the set says it isn't here
+        return NULL;
+    }
+    for(i = 0; i < deck->count; i++) {
+        if(check_flag(deck->cards[i]->flags,cflags)) {
             //Found what we are looking for
-            break;
+            return deck->cards[i];
         }
-        result = result->next;
     }
-    return result;
+    return NULL;
 }
 
 void move_top_card_to_deck(Deck *from, Deck *to) {
-    if(!from || !to) return;
-    if(!from->cards) return;
-    Card *card = remove_card_from_deck(from, from->cards);
-    add_card_to_deck(to, card);
+    draw_card(from, to);
 }
 
 void move_last_card_to_deck(Deck *from, Deck *to) {
     if(!from || !to) return;
-    if(!from->cards) return;
-    //Card *card = remove_card_from_deck(from, from->cards);
-    Card *card = from->cards;
-    while(card->next) {
-        card = card->next;
-    }
-    remove_card_from_deck(from, card);
-    add_card_to_deck(to, card);
+    if(!from->count) return;
+    splice_cards(from, from->count - 1, to, false);
 }
 
 void move_chain_card(Card *card, Deck *from, Deck *to) {
     // Move a chain of cards, starting with "card" from "from" to "to"
     if(!card || !from || !to) return;
-    Card *lasttocard = get_last_card(to);
-    if(!lasttocard) {
-        // Moving chain to empty deck
-        // Set that deck->cards = card
-        to->cards = card;
-        if(card->prev) {
-            // Other cards in "from"
-            card->prev->next = NULL;
-            card->prev = NULL;
-        } else {
-            // No other cards in "from"
-            from->cards = NULL;
+    splice_cards(from, find_card_in_deck(from, card), to, false);
+}
+
+bool splice_cards(Deck *from, int i, Deck *to, bool reverse) {
+    /* Every multi-card move goes through here. The run of cards from
+     * from->cards[i] to the last card is taken off the end of "from" and put
+     * on the end of "to", in the same order - or reversed if reverse is set,
+     * which is what moving them over one at a time off the end would do
+     * (dealing a sequence up onto a foundation). Nothing is searched for or
+     * counted, both ends are just count, so this is one copy of the run.
+     * Returns false (and moves nothing) if there's no such run, or it won't
+     * fit. */
+    int n = 0, j = 0;
+    if(!from || !to || (from == to)) return false;
+    if((i < 0) || (i >= from->count)) return false;
+    n = from->count - i;
+    if(to->count + n > to->cap) return false;
+    if(reverse) {
+        for(j = 0; j < n; j++) {
+            to->cards[to->count + j] = from->cards[from->count - 1 - j];
         }
-        // Make sure the count in both "to" and "from" is accurate.
-        to->count = count_cards(to->cards);
-        from->count = count_cards(from->cards);
     } else {
-        // Moving chain to another card
-        // First, need to check and sever the chain from the "from" deck
-        if(card->prev) {
-            //Other cards in "from"
-            card->prev->next = NULL;
-        } else {
-            //No other cards in "from", need to NULL the from->cards
-            from->cards = NULL;
-        }
-        // Reattach chain to "to deck"
-        card->prev = lasttocard;
-        lasttocard->next = card;
-        // Make sure the count in both "to" and "from" is accurate.
-        to->count = count_cards(to->cards);
-        from->count = count_cards(from->cards);
+        memcpy(&to->cards[to->count], &from->cards[i], n * sizeof(Card*));
+    }
+    for(j = i; j < from->count; j++) {
+        deck_note_out(from, from->cards[j]);
+        deck_note_in(to, from->cards[j]);
     }
+    to->count += n;
+    from->count = i;
+    return true;
+}
+
+void swap_cards(Deck *a, int i, Deck *b, int j) {
+    // Trade a->cards[i] and b->cards[j] (Penguin's cells)
+    Card *tmp = NULL;
+    if(!a || !b) return;
+    if((i < 0) || (i >= a->count) || (j < 0) || (j >= b->count)) return;
+    if((a == b) && (i == j)) return;
+    tmp = a->cards[i];
+    deck_note_out(a, tmp);
+    deck_note_out(b, b->cards[j]);
+    a->cards[i] = b->cards[j];
+    b->cards[j] = tmp;
+    deck_note_in(a, a->cards[i]);
+    deck_note_in(b, b->cards[j]);
+}
+
+Card* get_first_card(Deck *deck) {
+    if(!deck || !deck->count) return NULL;
+    return deck->cards[0];
 }
 
 Card* get_last_card(Deck *deck) {
-    if(!deck) return NULL;
-    if(!deck->cards) return NULL;
-    Card *card = deck->cards;
-    while(card->next) {
-        card = card->next;
-    }
-    return card;
+    if(!deck || !deck->count) return NULL;
+    return deck->cards[deck->count - 1];
 }
 
 Card* get_card_at(Deck *deck, int n) {
     if(!deck) return NULL;
-    if(!deck->cards) return NULL;
-    int i = 0;
-    Card *result = deck->cards;
-    while((i < n) && result) {
-        result = result->next;
-        i++;
+    if((n < 0) || (n >= deck->count)) return NULL;
+    return deck->cards[n];
+}
+
+/*****
+ * Card tables
+ *****/
+CardTables g_cardtab;
+
+int card_id(int cflags) {
+    /* Turn a card's flags into its id, suite * 13 + rank - 1 with the suites
+     * in flag order (H, S, C, D). Returns -1 if there isn't both a rank and a
+     * suite in the flags. */
+    int rank = cflags & CD_RANKS;
+    int suite = cflags & CD_SUITES;
+    if(!rank || !suite) return -1;
+    return ((__builtin_ctz(suite) - 14) * 13) + __builtin_ctz(rank) - 1;
+}
+
+CardSet card_bit(int cflags) {
+    // The card's bit in a CardSet, 0 if the flags aren't a card
+    int id = card_id(cflags);
+    if(id < 0) return 0;
+    return (CardSet)1 << id;
+}
+
+CardSet cardset_of(int cflags) {
+    /* Every card that has the rank(s) and suite(s) in cflags - cardset_of(CD_5)
+     * is all four fives, cardset_of(CD_5 | CD_H) is just the five of hearts.
+     * Other flags are ignored. */
+    CardSet ranks = 0, suites = 0;
+    int r = cflags & CD_RANKS, su = cflags & CD_SUITES;
+    if(!r) ranks = CARDSET_ALL;
+    while(r) {
+        ranks |= g_cardtab.ranks[__builtin_ctz(r)];
+        r &= r - 1;
+    }
+    if(!su) suites = CARDSET_ALL;
+    while(su) {
+        suites |= g_cardtab.suites[__builtin_ctz(su) - 14];
+        su &= su - 1;
+    }
+    return ranks & suites;
+}
+
+CardSet cardset_worth_upto(int value) {
+    // Every card that counts value or less in cribbage (face cards are 10)
+    if(value <= 0) return 0;
+    if(value >= 10) return CARDSET_ALL;
+    return cardset_of(rank_to_cflag(value + 1) - CD_A); // A up to value
+}
+
+int cardset_count(CardSet set) {
+    return __builtin_popcountll(set);
+}
+
+void init_card_tables(void) {
+    /* Work out everything about every card once, up front, so the rules can
+     * just look it up */
+    const char *ranks = "A23456789TJQK";
+    const char *suites = "hscd";
+    const char *symbols[4] = {"\u2665", "\u2660", "\u2663", "\u2666"};
+    const int suite_order[4] = {1, 2, 0, 3}; // Sorting order of H, S, C, D
+    int i = 0, j = 0, ri = 0, rj = 0;
+    CardTables *t = &g_cardtab;
+    memset(t, 0, sizeof(CardTables));
+    for(i = 0; i < CARD_IDS; i++) {
+        ri = (i % 13) + 1;
+        t->cflags[i] = (1 << ri) | (CD_H << (i / 13));
+        t->rank[i] = ri;
+        t->rank_ch[i] = ranks[ri - 1];
+        t->suite[i] = suites[i / 13];
+        t->red[i] = ((t->cflags[i] & (CD_H | CD_D)) != 0);
+        t->value[i] = (ri > 10) ? 10 : ri;
+        if(ri == 10) {
+            snprintf(t->rank_str[i], 3, "10");
+        } else {
+            snprintf(t->rank_str[i], 3, "%c", t->rank_ch[i]);
+        }
+        snprintf(t->suite_str[i], 4, "%s", symbols[i / 13]);
+        snprintf(t->name[i], 8, "%s%s", t->suite_str[i], t->rank_str[i]);
+        t->ranks[ri] |= (CardSet)1 << i;
+        t->suites[i / 13] |= (CardSet)1 << i;
+        t->rank_order[i] = ((ri - 1) * 4) + suite_order[i / 13];
+        t->suite_order[i] = (suite_order[i / 13] * 13) + ri - 1;
+    }
+    for(i = 0; i < CARD_IDS; i++) {
+        ri = t->rank[i];
+        for(j = 0; j < CARD_IDS; j++) {
+            rj = t->rank[j];
+            if((rj == ri - 1) && (t->red[i] != t->red[j])) {
+                t->stacks[i] |= (CardSet)1 << j;
+            }
+            if(t->suite[i] != t->suite[j]) continue;
+            if(rj == ri + 1) {
+                t->follows[i] |= (CardSet)1 << j;
+            }
+            if((rj == ri + 1) || ((ri == 13) && (rj == 1))) {
+                t->wraps[i] |= (CardSet)1 << j;
+            }
+        }
     }
-    return result;
+}
+
+bool card_stacks_on(int a, int b) {
+    // Can card 'b' go on card 'a' on a Klondike tableau?
+    int ia = card_id(a), ib = card_id(b);
+    if((ia < 0) || (ib < 0)) return false;
+    return ((g_cardtab.stacks[ia] >> ib) & 1);
+}
+
+bool card_follows(int a, int b) {
+    // Is card 'a' the same suite as and exactly one higher than card 'b'?
+    int ia = card_id(a), ib = card_id(b);
+    if((ia < 0) || (ib < 0)) return false;
+    return ((g_cardtab.follows[ib] >> ia) & 1);
+}
+
+bool card_follows_wrap(int a, int b) {
+    // As above, but an A is one higher than a K
+    int ia = card_id(a), ib = card_id(b);
+    if((ia < 0) || (ib < 0)) return false;
+    return ((g_cardtab.wraps[ib] >> ia) & 1);
 }
 
 /*****
@@ -243,23 +422,7 @@ Card* get_card_at(Deck *deck, int n) {
  *****/
 int get_card(int value, char suite) {
     /* Turns a card value and a char suite (HSDC) into a bitflag int */
-    int card = CD_NONE;
-    switch(value) {
-        case 1: card = CD_A; break;
-        case 2: card = CD_2; break;
-        case 3: card = CD_3; break;
-        case 4: card = CD_4; break;
-        case 5: card = CD_5; break;
-        case 6: card = CD_6; break;
-        case 7: card = CD_7; break;
-        case 8: card = CD_8; break;
-        case 9: card = CD_9; break;
-        case 10: card = CD_10; break;
-        case 11: card = CD_J; break;
-        case 12: card = CD_Q; break;
-        case 13: card = CD_K; break;
-        default: card = CD_NONE; break;
-    }
+    int card = rank_to_cflag(value);
     switch(suite) {
         case 'S':
         case 's': card |= CD_S; break;
@@ -291,11 +454,11 @@ bool card_clubs(int card) {
 }
 
 bool card_black(int card) {
-    return (card_spades(card) || card_clubs(card));
+    return ((card & (CD_S | CD_C)) != 0);
 }
 
 bool card_red(int card) {
-    return (card_hearts(card) || card_diamonds(card));
+    return ((card & (CD_H | CD_D)) != 0);
 }
 
 bool card_alt_color(int a, int b) {
@@ -304,11 +467,11 @@ bool card_alt_color(int a, int b) {
 }
 
 bool card_same_suite(int a, int b) {
-    return (get_suite(a) == get_suite(b));
+    return ((a & CD_SUITES) == (b & CD_SUITES));
 }
 
 bool card_same_rank(int a, int b) {
-    return(get_rank(a) == get_rank(b));
+    return ((a & CD_RANKS) == (b & CD_RANKS));
 }
 
 bool card_in_asc_sequence(int a, int b) {
@@ -317,245 +480,168 @@ bool card_in_asc_sequence(int a, int b) {
 }
 
 char get_suite(int card) {
-    char result = '\0';
-    if(card_hearts(card)) {
-        result = 'h';
-    } else if (card_diamonds(card)) {
-        result = 'd';
-    } else if (card_clubs(card)) {
-        result = 'c';
-    } else if (card_spades(card)) {
-        result = 's';
-    }
-    return result;
+    int suite = card & CD_SUITES;
+    if(!suite) return '\0';
+    return "hscd"[__builtin_ctz(suite) - 14];
 }
 
 int get_rank(int card) {
-    int result = 0;
-    if(check_flag(card, CD_A)) {
-        result = 1;
-    } else if (check_flag(card,CD_2)) {
-        result = 2;
-    } else if (check_flag(card,CD_2)) {
-        result = 2;
-    } else if (check_flag(card,CD_3)) {
-        result = 3;
-    } else if (check_flag(card,CD_4)) {
-        result = 4;
-    } else if (check_flag(card,CD_5)) {
-        result = 5;
-    } else if (check_flag(card,CD_6)) {
-        result = 6;
-    } else if (check_flag(card,CD_7)) {
-        result = 7;
-    } else if (check_flag(card,CD_8)) {
-        result = 8;
-    } else if (check_flag(card,CD_9)) {
-        result = 9;
-    } else if (check_flag(card,CD_10)) {
-        result = 10;
-    } else if (check_flag(card,CD_J)) {
-        result = 11;
-    } else if (check_flag(card,CD_Q)) {
-        result = 12;
-    } else if (check_flag(card,CD_K)) {
-        result = 13;
-    }
-    return result;
+    // The rank flags are 1 << rank, so the rank is the bit number
+    int rank = card & CD_RANKS;
+    if(!rank) return 0;
+    return __builtin_ctz(rank);
 }
 
 char get_rank_ch(int card) {
-    char result = '\0';
-    if(check_flag(card, CD_A)) {
-        result = 'A';
-    } else if (check_flag(card,CD_2)) {
-        result = '2';
-    } else if (check_flag(card,CD_2)) {
-        result = '2';
-    } else if (check_flag(card,CD_3)) {
-        result = '3';
-    } else if (check_flag(card,CD_4)) {
-        result = '4';
-    } else if (check_flag(card,CD_5)) {
-        result = '5';
-    } else if (check_flag(card,CD_6)) {
-        result = '6';
-    } else if (check_flag(card,CD_7)) {
-        result = '7';
-    } else if (check_flag(card,CD_8)) {
-        result = '8';
-    } else if (check_flag(card,CD_9)) {
-        result = '9';
-    } else if (check_flag(card,CD_10)) {
-        result = 'T';
-    } else if (check_flag(card,CD_J)) {
-        result = 'J';
-    } else if (check_flag(card,CD_Q)) {
-        result = 'Q';
-    } else if (check_flag(card,CD_K)) {
-        result = 'K';
-    }
-    return result;
+    return "\0A23456789TJQK"[get_rank(card)];
 }
+
 int get_rank_flag(int card) {
     // Just need to return the flag & ~(suites)
-    return (card & ~(CD_H | CD_D | CD_C | CD_S));
+    return (card & ~CD_SUITES);
 }
 
 int get_suite_flag(int card) {
     // Just need to return the flag & ~(rank)
-    return (card & 
-            ~(CD_A | CD_2 | CD_3 | CD_4 | CD_5 | CD_6 | 
-              CD_7 | CD_8 | CD_9 | CD_10 | CD_J | CD_Q | CD_K));
+    return (card & ~CD_RANKS);
 }
 
 uint32_t rank_to_cflag(int rank) {
-    uint32_t result = CD_NONE;
-    switch(rank) {
-        case 1: result = CD_A; break;
-        case 2: result = CD_2; break;
-        case 3: result = CD_3; break;
-        case 4: result = CD_4; break;
-        case 5: result = CD_5; break;
-        case 6: result = CD_6; break;
-        case 7: result = CD_7; break;
-        case 8: result = CD_8; break;
-        case 9: result = CD_9; break;
-        case 10: result = CD_10; break;
-        case 11: result = CD_J; break;
-        case 12: result = CD_Q; break;
-        case 13: result = CD_K; break;
-        default: result = CD_NONE; break;
-    }
-    return result;
+    if((rank < 1) || (rank > 13)) return CD_NONE;
+    return (1 << rank);
 }
 
-char* get_card_str(Card *card) {
-    // Given a card, return a string contain the suite/rank
-    /*
-     * ♠ u2660, ♤ u2664
-     * ♥ u2665, ♡ u2661
-     * ♦ u2666, ♢ u2662
-     * ♣ u2663, ♧ u2667
-     */
-    char *result = malloc(9 * sizeof(char));
-    
-    char suite = get_suite(card->flags);
-    char rank = get_rank_ch(card->flags);
-
-    if(rank == 'T') {
-        if(suite == 's') {
-            snprintf(result,9,"%s10", "\u2660");
-        } else if(suite == 'h') {
-            snprintf(result,9,"%s10", "\u2665");
-        } else if(suite == 'd') {
-            snprintf(result,9,"%s10", "\u2666");
-        } else if(suite == 'c') {
-            snprintf(result,9,"%s10", "\u2663");
-        }
-    } else {
-        if(suite == 's') {
-            snprintf(result,9,"%s%c", "\u2660",rank);
-        } else if(suite == 'h') {
-            snprintf(result,9,"%s%c", "\u2665",rank);
-        } else if(suite == 'd') {
-            snprintf(result,9,"%s%c", "\u2666",rank);
-        } else if(suite == 'c') {
-            snprintf(result,9,"%s%c", "\u2663",rank);
-        }
-    }
-
-    return result;
+const char* get_card_str(Card *card) {
+    // Given a card, return a string containing the suite/rank. The names are
+    // all made once in init_card_tables(), so this is never malloc'd and
+    // shouldn't be freed.
+    int id = card ? card_id(card->flags) : -1;
+    if(id < 0) return "";
+    return g_cardtab.name[id];
 }
 
 void shuffle_deck(Deck *deck) {
-    int rounds = 500; // Seems about right for a truly random shuffle
-    int i,j,n;
-    int size = deck->count;
-    Card *tmp = NULL;
-    for(i = 0; i < rounds; i++) {
-        tmp = deck->cards;
-        if(!tmp) break;
-        n = mt_rand(0,size - 1);
-        j = 0;
-        while(j != n) {
-            tmp = tmp->next;
-            j++;
-        }
-        add_card_to_deck(deck, remove_card_from_deck(deck,tmp));
-    }
+    shuffle_deck_rng(deck, &g_rng);
 }
 
-/*****
- * Card/Deck sorting
- *****/
-Card* sorted_merge(Card *a, Card *b, bool bysuite) {
-    Card *result = NULL;
-    if(!a) {
-        return b;
-    } else if(!b) {
-        return a;
-    }
-    int aval = get_rank(a->flags);
-    int bval = get_rank(b->flags);
-    if(bysuite) {
-        if((a->flags & CD_H) == CD_H) aval += 13;
-        if((a->flags & CD_S) == CD_S) aval += 26;
-        if((a->flags & CD_D) == CD_D) aval += 39;
-
-        if((b->flags & CD_H) == CD_H) bval += 13;
-        if((b->flags & CD_S) == CD_S) bval += 26;
-        if((b->flags & CD_D) == CD_D) bval += 39;
-    }
-    if(aval <= bval) {
-        result = a;
-        result->next = sorted_merge(a->next, b, bysuite);
-    } else {
-        result = b;
-        result->next = sorted_merge(a, b->next, bysuite);
+void shuffle_deck_rng(Deck *deck, Rng *rng) {
+    /* Fisher-Yates: walk down the pile swapping each spot with a random one
+     * at or below it. One pass, and every order of the cards is equally
+     * likely (as long as the random draw isn't skewed, see rng_bounded()).
+     * The random numbers come from rng, so a game with its own stream gets
+     * the same shuffles no matter what else draws random numbers. */
+    int i = 0, j = 0;
+    Card *tmp = NULL;
+    if(!deck || (deck->count < 2)) return;
+    for(i = deck->count - 1; i > 0; i--) {
+        j = rng_bounded(rng, i + 1);
+        tmp = deck->cards[i];
+        deck->cards[i] = deck->cards[j];
+        deck->cards[j] = tmp;
     }
-    return result;
 }
 
-void ft_bk_splt(Card *source, Card **frontref, Card **backref) {
-    Card *fast = NULL;
-    Card *slow = NULL;
-    slow = source;
-    fast = source->next;
-    while(fast) {
-        fast = fast->next;
-        if(fast) {
-            slow = slow->next;
-            fast = fast->next;
-        }
+void shuffle_deck_bulk(Deck *deck, RngBulk *bulk) {
+    // Same as shuffle_deck_rng(), but the numbers come out of bulk's buffer
+    int i = 0, j = 0;
+    Card *tmp = NULL;
+    if(!deck || (deck->count < 2)) return;
+    for(i = deck->count - 1; i > 0; i--) {
+        j = rng_bulk_bounded(bulk, i + 1);
+        tmp = deck->cards[i];
+        deck->cards[i] = deck->cards[j];
+        deck->cards[j] = tmp;
     }
-    *frontref = source;
-    *backref = slow->next;
-    slow->next = NULL;
-}
-
-void merge_sort_deck(Deck *deck) {
-    merge_sort_cards_bysuite(&(deck->cards),false);
 }
 
-void merge_sort_cards(Card **headref) {
-    merge_sort_cards_bysuite(headref,false);
-}
-
-void merge_sort_deck_bysuite(Deck *deck, bool bysuite) {
-    merge_sort_cards_bysuite(&(deck->cards), bysuite);
+/*****
+ * Numbered deals
+ *****/
+static uint64_t s_next_deal = 0; // Deal the next game plays, 0 for random
+
+void set_next_deal(uint64_t deal) {
+    s_next_deal = deal;
+}
+
+uint64_t peek_next_deal(void) {
+    return s_next_deal;
+}
+
+bool parse_deal(const char *str, uint64_t *deal) {
+    /* A deal number typed in by the player (1 to 2^64 - 1), spaces or a
+     * newline around it are fine. Returns false, and leaves deal alone, for
+     * anything else - strtoull() on its own takes "abc" as 0 (a random
+     * deal) and "-1" as a huge number. */
+    char *end = NULL;
+    unsigned long long n = 0;
+    if(!str) return false;
+    while(isspace((unsigned char)*str)) str++;
+    if(!isdigit((unsigned char)*str)) return false;
+    errno = 0;
+    n = strtoull(str, &end, 10);
+    if(errno == ERANGE) return false;
+    while(isspace((unsigned char)*end)) end++;
+    if(*end || !n) return false;
+    *deal = n;
+    return true;
+}
+
+uint64_t take_next_deal(void) {
+    /* The deal picked with set_next_deal() (only once, a restart after that
+     * gets a random one), or a random deal number. Random deals stick to 32
+     * bits so they're easy to read out and type back in, but any 64 bit deal
+     * number can be played. 0 is never a deal, it means "unknown". */
+    uint64_t deal = s_next_deal;
+    s_next_deal = 0;
+    if(!deal) deal = 1 + (uint64_t)rng_bounded(&g_rng, UINT32_MAX);
+    return deal;
+}
+
+void shuffle_deal(Deck *deck, Rng *rng, uint64_t deal) {
+    /* Deal number -> shuffle. rng is reseeded from the deal number and then
+     * shuffles deck, so the same deal (and the same cards in the same order
+     * going in) is always the same game, and everything random after this
+     * that draws from rng follows from the deal too. Always xoshiro, so the
+     * deal numbers mean the same thing whatever RNG_DEFAULT is. */
+    rng_init_kind(rng, RNG_XOSHIRO, deal);
+    shuffle_deck_rng(deck, rng);
 }
 
-void merge_sort_cards_bysuite(Card **headref, bool bysuite) {
-    Card *head = *headref;
-    Card *a = NULL;
-    Card *b = NULL;
-
-    if(!head || !head->next) return;
-    ft_bk_splt(head, &a, &b);
-    merge_sort_cards_bysuite(&a,bysuite);
-    merge_sort_cards_bysuite(&b,bysuite);
-    *headref = sorted_merge(a,b,bysuite);
+/*****
+ * Card/Deck sorting
+ *****/
+void sort_deck(Deck *deck) {
+    sort_deck_bysuite(deck,false);
+}
+
+void sort_deck_bysuite(Deck *deck, bool bysuite) {
+    /* Counting sort - there are only 52 different cards, so count how many of
+     * each there are, work out where each one starts, and drop the cards
+     * straight into place. One pass to count, one to place, no comparing.
+     * Sorted by rank (then suite), or by suite (then rank) if bysuite is set.
+     * Suites go clubs, hearts, spades, diamonds. Anything that isn't a card
+     * goes on the end. */
+    int start[CARD_IDS + 1];
+    Card *tmp[PILE_MAX];
+    uint8_t *key = bysuite ? g_cardtab.suite_order : g_cardtab.rank_order;
+    int i = 0, k = 0, n = 0, id = 0;
+    if(!deck || (deck->count < 2)) return;
+    memset(start, 0, sizeof(start));
+    for(i = 0; i < deck->count; i++) {
+        id = card_id(deck->cards[i]->flags);
+        start[(id < 0) ? CARD_IDS : key[id]] += 1;
+    }
+    for(k = 0; k <= CARD_IDS; k++) {
+        i = start[k];
+        start[k] = n;
+        n += i;
+    }
+    for(i = 0; i < deck->count; i++) {
+        id = card_id(deck->cards[i]->flags);
+        k = (id < 0) ? CARD_IDS : key[id];
+        tmp[start[k]++] = deck->cards[i];
+    }
+    memcpy(deck->cards, tmp, deck->count * sizeof(Card*));
 }
 
 /*****
@@ -614,58 +700,23 @@ void pt_card_simple(int x, int y, Card *card) {
     int cflags = card->flags;
     int fg = (card_red(cflags) ? g_settings->redcolor : g_settings->blackcolor);
     int bg = g_settings->bgcolor;
-    char *fstr = malloc(8 * sizeof(char));
-    char *rankstr = malloc(4 * sizeof(char));
-    int rank = get_rank(cflags);
-    if(13 == rank) {
-        snprintf(rankstr,4,"K");
-    } else if (12 == rank) {
-        snprintf(rankstr,4,"Q");
-    } else if (11 == rank) {
-        snprintf(rankstr,4,"J");
-    } else if (1 == rank) {
-        snprintf(rankstr,4,"A");
-    } else {
-        snprintf(rankstr,4,"%d",rank);
-    }
-    switch(get_suite(cflags)) {
-        case 'h': snprintf(fstr, 8, "\u2665%s", rankstr); break;
-        case 'd': snprintf(fstr, 8, "\u2666%s", rankstr); break;
-        case 'c': snprintf(fstr, 8, "\u2663%s", rankstr); break;
-        case 's': snprintf(fstr, 8, "\u2660%s", rankstr); break;
-        default: break;
-    }
-    scr_pt_clr(x,y,fg,bg,"%s",fstr);
+    int id = card_id(cflags);
+    if(id < 0) return;
+    scr_pt_clr(x,y,fg,bg,"%s",g_cardtab.name[id]);
     scr_reset();
-    free(fstr);
-    free(rankstr);
 }
 
 void pt_card(int x, int y, Card *card) {
     int cflags = card->flags;
     int fg = (card_red(cflags) ? g_settings->redcolor : g_settings->blackcolor);
     int bg = g_settings->bgcolor;
-    char *sstr = malloc(8 * sizeof(char));
-    char *rankstr = malloc(4 * sizeof(char));
-    int rank = get_rank(cflags);
-    if(13 == rank) {
-        snprintf(rankstr,4,"K");
-    } else if (12 == rank) {
-        snprintf(rankstr,4,"Q");
-    } else if (11 == rank) {
-        snprintf(rankstr,4,"J");
-    } else if (1 == rank) {
-        snprintf(rankstr,4,"A");
-    } else {
-        snprintf(rankstr,4,"%d",rank);
-    }
-    switch(get_suite(cflags)) {
-        case 'h': snprintf(sstr, 8, "\u2665"); break;
-        case 'd': snprintf(sstr, 8, "\u2666"); break;
-        case 'c': snprintf(sstr, 8, "\u2663"); break;
-        case 's': snprintf(sstr, 8, "\u2660"); break;
-        default: break;
-    }
+    int id = card_id(cflags);
+    int rank = 0;
+    char *sstr = NULL, *rankstr = NULL;
+    if(id < 0) return;
+    rank = g_cardtab.rank[id];
+    sstr = g_cardtab.suite_str[id];
+    rankstr = g_cardtab.rank_str[id];
 
     scr_pt_clr(x,y,fg,bg,"\u2554\u2550\u2550\u2557");
     scr_pt_clr(x,y+1,fg,bg,"\u2551%s \u2551",sstr);
@@ -675,8 +726,6 @@ void pt_card(int x, int y, Card *card) {
         scr_pt_clr(x,y+2,fg,bg,"\u2551 %s\u2551",rankstr);
     }
     scr_pt_clr(x,y+3,fg,bg,"\u255A\u2550\u2550\u255D");
-    free(sstr);
-    free(rankstr);
 }
 
 void pt_card_blink(int x, int y, Card *card) {
@@ -688,27 +737,13 @@ void pt_card_blink(int x, int y, Card *card) {
     int cflags = card->flags;
     int fg = (card_red(cflags) ? g_settings->redcolor : g_settings->blackcolor);
     int bg = g_settings->bgcolor;
-    char *sstr = malloc(8 * sizeof(char));
-    char *rankstr = malloc(4 * sizeof(char));
-    int rank = get_rank(cflags);
-    if(13 == rank) {
-        snprintf(rankstr,4,"K");
-    } else if (12 == rank) {
-        snprintf(rankstr,4,"Q");
-    } else if (11 == rank) {
-        snprintf(rankstr,4,"J");
-    } else if (1 == rank) {
-        snprintf(rankstr,4,"A");
-    } else {
-        snprintf(rankstr,4,"%d",rank);
-    }
-    switch(get_suite(cflags)) {
-        case 'h': snprintf(sstr, 8, "\u2665"); break;
-        case 'd': snprintf(sstr, 8, "\u2666"); break;
-        case 'c': snprintf(sstr, 8, "\u2663"); break;
-        case 's': snprintf(sstr, 8, "\u2660"); break;
-        default: break;
-    }
+    int id = card_id(cflags);
+    int rank = 0;
+    char *sstr = NULL, *rankstr = NULL;
+    if(id < 0) return;
+    rank = g_cardtab.rank[id];
+    sstr = g_cardtab.suite_str[id];
+    rankstr = g_cardtab.rank_str[id];
 
     scr_pt_clr(x,y,fg,bg,"\u2554\u2550\u2550\u2557");
     scr_pt_clr(x,y+1,fg,bg,"\u2551  \u2551");
@@ -727,8 +762,6 @@ void pt_card_blink(int x, int y, Card *card) {
         scr_set_style(ST_NONE);
     }
     scr_pt_clr(x,y+3,fg,bg,"\u255A\u2550\u2550\u255D");
-    free(sstr);
-    free(rankstr);
 }
 void pt_card_top(int x, int y, Card *card) {
     /*
@@ -770,30 +803,17 @@ void pt_card_top_blink(int x, int y, Card *card) {
 void pt_card_suite(int x, int y, Card *card) {
     int fg = (card_red(card->flags) ? g_settings->redcolor : g_settings->blackcolor);
     int bg = g_settings->bgcolor;
-    switch(get_suite(card->flags)) {
-        case 'h': scr_pt_clr(x,y,fg,bg,"\u2665"); break;
-        case 'd': scr_pt_clr(x,y,fg,bg,"\u2666"); break;
-        case 'c': scr_pt_clr(x,y,fg,bg,"\u2663"); break;
-        case 's': scr_pt_clr(x,y,fg,bg,"\u2660"); break;
-        default: break;
-    }
+    int id = card_id(card->flags);
+    if(id < 0) return;
+    scr_pt_clr(x,y,fg,bg,"%s",g_cardtab.suite_str[id]);
 }
 
 void pt_card_rank(int x, int y, Card *card) {
-    int rank = get_rank(card->flags);
     int fg = (card_red(card->flags) ? g_settings->redcolor : g_settings->blackcolor);
     int bg = g_settings->bgcolor;
-    if(13 == rank) {
-        scr_pt_clr(x,y,fg,bg,"K");
-    } else if (12 == rank) {
-        scr_pt_clr(x,y,fg,bg,"Q");
-    } else if (11 == rank) {
-        scr_pt_clr(x,y,fg,bg,"J");
-    } else if (1 == rank) {
-        scr_pt_clr(x,y,fg,bg,"A");
-    } else {
-        scr_pt_clr(x,y,fg,bg,"%d",rank);
-    }
+    int id = card_id(card->flags);
+    if(id < 0) return;
+    scr_pt_clr(x,y,fg,bg,"%s",g_cardtab.rank_str[id]);
 }
 
 void pt_card_left(int x, int y, Card *card) {
@@ -950,24 +970,22 @@ void pt_card_special_rank(int x, int y, int cflags, char ch) {
  * ♦ u2666, ♢ u2662
  * ♣ u2663, ♧ u2667
  */
-    char *suite = malloc(6 * sizeof(char));
+    const char *suite = "";
     int fg = (card_red(cflags) ? g_settings->redcolor : g_settings->blackcolor);
     int bg = g_settings->bgcolor;
     if(card_hearts(cflags)) {
-        strcpy(suite,"\u2665");
+        suite = "\u2665";
     } else if (card_diamonds(cflags)) {
-        strcpy(suite,"\u2666");
+        suite = "\u2666";
     } else if (card_clubs(cflags)) {
-        strcpy(suite,"\u2663");
+        suite = "\u2663";
     } else if (card_spades(cflags)) {
-        strcpy(suite,"\u2660");
+        suite = "\u2660";
     }
     scr_pt_clr(x,y,fg,bg,"\u2554\u2550\u2550\u2557");
     scr_pt_clr(x,y+1,fg,bg,"\u2551%s \u2551",suite);
     scr_pt_clr(x,y+2,fg,bg,"\u2551 %c\u2551",ch);
     scr_pt_clr(x,y+3,fg,bg,"\u255A\u2550\u2550\u255D");
-
-    free(suite);
 }
 
 void pt_card_title(int x, int y, char *str) {
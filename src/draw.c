@@ -309,10 +309,7 @@ char draw_cmenu(SList *menu, uint8_t fg, uint8_t bg, uint8_t boxcolor) {
     draw_screen(g_screenbuf);
 
     // Wait for input
-    while(true) {
-        result = kb_get_char();
-        if(result != '\0') break;
-    }
+    result = kb_get_bl_char();
 
     // Return input
     return result;
@@ -0,0 +1,323 @@
+/*
+* Cards
+* Copyright (C) Zach Wilder 2024
+* 
+* This file is a part of Cards
+*
+* Cards is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+* 
+* Cards is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+* 
+* You should have received a copy of the GNU General Public License
+* along with Cards.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#include <cards.h>
+#include <ctype.h>
+
+GameLoop* create_game_loop(uint32_t *flags) {
+    GameLoop *loop = malloc(sizeof(GameLoop));
+    loop->name = "game";
+    loop->events = NULL;
+    loop->update = NULL;
+    loop->draw = NULL;
+    loop->tick = NULL;
+    loop->click = NULL;
+    loop->flags = flags;
+    loop->frame_ms = LOOP_FRAME_MS;
+    loop->last_draw_us = 0;
+    tw_init(&loop->timers, loop_us() / 1000);
+    loop->prompt.text[0] = '\0';
+    loop->prompt.fn = NULL;
+    loop->prompt.data = NULL;
+    loop->prompt.active = false;
+    memset(&loop->stats, 0, sizeof(LoopStats));
+    lh_reset(&loop->latency);
+    loop->nkeywait = 0;
+    return loop;
+}
+
+static void game_loop_dump_stats(GameLoop *loop);
+
+void game_loop_reset(GameLoop *loop) {
+    /* Get the loop ready for a new game without making a new one - timers
+     * and any prompt from the last game are dropped, the stats carry on. */
+    if(!loop) return;
+    tw_init(&loop->timers, loop_us() / 1000);
+    loop->prompt.text[0] = '\0';
+    loop->prompt.fn = NULL;
+    loop->prompt.data = NULL;
+    loop->prompt.active = false;
+    loop->nkeywait = 0;
+    loop->last_draw_us = 0;
+}
+
+void destroy_game_loop(GameLoop *loop) {
+    if(!loop) return;
+    game_loop_dump_stats(loop);
+    free(loop);
+}
+
+long loop_us(void) {
+    // Monotonic clock in microseconds, for timing the loop phases
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (ts.tv_sec * 1000000) + (ts.tv_nsec / 1000);
+}
+
+int game_loop_after(GameLoop *loop, long ms, TimerFn fn, void *data) {
+    /* Have the loop call fn(data) in ms milliseconds. Returns a timer id for
+     * game_loop_cancel(), or -1 if it couldn't be scheduled. */
+    return tw_add(&loop->timers, loop_us() / 1000, ms, fn, data);
+}
+
+void game_loop_cancel(GameLoop *loop, int id) {
+    // Safe to call with -1 or with a timer that already went off
+    tw_cancel(&loop->timers, id);
+}
+
+void game_loop_vprompt(GameLoop *loop, PromptFn fn, void *data, char *fstr,
+        va_list args) {
+    /* Put a question at the bottom of the screen. The loop keeps going
+     * (drawing, timers, resizes) but events/update are held off until the
+     * player presses a key, which is then handed to fn. */
+    vsnprintf(loop->prompt.text, LOOP_PROMPT_SZ, fstr, args);
+    loop->prompt.fn = fn;
+    loop->prompt.data = data;
+    loop->prompt.active = true;
+    *loop->flags |= GFL_DRAW;
+}
+
+void game_loop_prompt(GameLoop *loop, PromptFn fn, void *data, char *fstr, ...) {
+    va_list args;
+    va_start(args, fstr);
+    game_loop_vprompt(loop, fn, data, fstr, args);
+    va_end(args);
+}
+
+static bool game_loop_answer(GameLoop *loop, KeyEvent *key) {
+    /* A key came in while a prompt is up. Plain keys answer it (special keys
+     * are skipped, same as kb_get_char()). */
+    PromptFn fn = loop->prompt.fn;
+    if((key->key <= 0) || (key->key >= 0x80)) return false;
+    loop->prompt.active = false;
+    *loop->flags |= GFL_DRAW;
+    if(fn) {
+        fn(toupper(key->key), loop->prompt.data);
+    }
+    return true;
+}
+
+static void game_loop_draw_prompt(GameLoop *loop) {
+    // Prompt goes on the last line of the screen, with a blinky cursor after
+    int xo = (g_screenW / 2) - (SCREEN_WIDTH / 2);
+    int yo = (g_screenH / 2) - (SCREEN_HEIGHT / 2);
+    scr_pt_clr(xo, 23+yo, WHITE, BLACK, "%*s", SCREEN_WIDTH - 2, "");
+    scr_pt_clr(xo, 23+yo, WHITE, BLACK, "%s", loop->prompt.text);
+    scr_set_style(ST_BLINK);
+    scr_pt(xo + strlen(loop->prompt.text) + 1, 23+yo, "█");
+    scr_set_style(ST_NONE);
+}
+
+static void game_loop_key_wait(GameLoop *loop, KeyEvent *key) {
+    // Remember when a key that was just handled came in, to time how long it
+    // takes to show up on the screen
+    if(loop->nkeywait < LOOP_MAX_BATCH) {
+        loop->keywait[loop->nkeywait++] = key->us;
+    }
+}
+
+static void game_loop_key_drawn(GameLoop *loop, long now) {
+    // A frame was just finished, so every key waiting on one made it
+    int i = 0;
+    for(i = 0; i < loop->nkeywait; i++) {
+        lh_record(&loop->latency, now - loop->keywait[i]);
+    }
+    loop->nkeywait = 0;
+}
+
+void game_loop_show_stats(GameLoop *loop) {
+    /* Debug key (F12), put the key latency numbers (and how often the last
+     * deal had to go to the heap) up as a prompt */
+    LatencyHist *h = &loop->latency;
+    game_loop_prompt(loop, NULL, NULL,
+            "Key to frame: p50 %.1fms p99 %.1fms max %.1fms (%lu keys) "
+            "allocs/deal %lu",
+            lh_percentile(h, 50.0) / 1000.0, lh_percentile(h, 99.0) / 1000.0,
+            h->max / 1000.0, h->total, loop->stats.deal_allocs);
+}
+
+void game_loop_write_stats(GameLoop *loop, FILE *fp) {
+    LatencyHist *h = &loop->latency;
+    LoopStats *st = &loop->stats;
+    fprintf(fp, "%s: key to frame latency, %lu keys: p50 %.2fms p90 %.2fms "
+            "p99 %.2fms p99.9 %.2fms max %.2fms\n", loop->name, h->total,
+            lh_percentile(h, 50.0) / 1000.0, lh_percentile(h, 90.0) / 1000.0,
+            lh_percentile(h, 99.0) / 1000.0, lh_percentile(h, 99.9) / 1000.0,
+            h->max / 1000.0);
+    fprintf(fp, "%s: %lu frames, %lu draws, %lu keys, %lu timers, %lu wakeups. "
+            "Time in events %.2fms, update %.2fms, draw %.2fms, timers %.2fms, "
+            "idle %.2fs. Longest frame %.2fms\n", loop->name, st->frames,
+            st->draws, st->keys, st->timers, st->wakeups,
+            st->events_us / 1000.0, st->update_us / 1000.0,
+            st->draw_us / 1000.0, st->timers_us / 1000.0,
+            st->idle_us / 1000000.0, st->max_frame_us / 1000.0);
+    fprintf(fp, "%s: %lu deals, %lu heap allocations past the arena in the "
+            "last deal\n", loop->name, st->deals, st->deal_allocs);
+}
+
+static void game_loop_dump_stats(GameLoop *loop) {
+    // If CARDS_LATENCY names a file, the stats for this game are added to it
+    char *path = getenv(LOOP_LATENCY_ENV);
+    FILE *fp = NULL;
+    if(!path || !path[0]) return;
+    fp = fopen(path, "a");
+    if(!fp) return;
+    game_loop_write_stats(loop, fp);
+    fclose(fp);
+}
+
+void game_loop_run(GameLoop *loop) {
+    /* Your standard events-update-render loop. The screen is only redrawn
+     * when the game does something that would make the display change (the
+     * way escape codes are used to clear/refresh the screen looks blinky
+     * otherwise), and never more often than once every frame_ms.
+     *
+     * Keys are handled in batches: everything the player has typed ahead
+     * (like "b", "c" for a whole move) goes through events/update one key at a
+     * time, in order, and the screen is only drawn once at the end. If one of
+     * those updates had to stop and ask the player something (a prompt), the
+     * batch ends there so the screen catches up before the rest of the keys
+     * are handled. While a prompt is up keys go to it instead of to events,
+     * and update isn't run. Mouse clicks are turned into keys by click(),
+     * clicks on nothing (or while a prompt is up) are dropped.
+     *
+     * Timers that are due go off at the start of each pass, before the keys,
+     * and tick (if the game has one) is called after them whenever a timer
+     * went off or the loop was woken up by the terminal's timer.
+     *
+     * Every key is timed from when it was read until the end of the frame
+     * that shows it (keys that don't change anything aren't counted). F12
+     * shows the numbers, and they're written out to $CARDS_LATENCY (if set)
+     * when the game is closed.
+     *
+     * When a pass through the loop didn't change anything the game is idle, so
+     * instead of spinning it sleeps in term_wait() until a key is pressed, the
+     * next timer is due, the terminal is resized, or a held back draw is due. */
+    KeyEvent key;
+    LoopStats *st = &loop->stats;
+    int ev = TE_NONE, nkeys = 0, wait = -1;
+    unsigned int blocks = 0;
+    unsigned long fired = 0;
+    long start = 0, t = 0, now = 0, next = 0;
+    *loop->flags |= GFL_RUNNING;
+    while(check_flag(*loop->flags, GFL_RUNNING)) {
+        start = loop_us();
+        fired = loop->timers.fired;
+        tw_advance(&loop->timers, start / 1000);
+        st->timers += loop->timers.fired - fired;
+        if(loop->tick && ((loop->timers.fired != fired) ||
+                    check_flag(ev, TE_TIMER))) {
+            loop->tick();
+        }
+        ev = TE_NONE;
+        st->timers_us += loop_us() - start;
+        nkeys = 0;
+        blocks = kb_block_count();
+        while((nkeys < LOOP_MAX_BATCH) && kb_get_key(&key)) {
+            if(key.key == KEY_MOUSE) {
+                if(loop->prompt.active) continue;
+                if(!loop->click || !loop->click(&key)) continue;
+            }
+            if((key.key == KEY_F12) && !loop->prompt.active) {
+                game_loop_show_stats(loop);
+                break;
+            }
+            t = loop_us();
+            game_loop_key_wait(loop, &key);
+            if(loop->prompt.active) {
+                if(!game_loop_answer(loop, &key)) continue;
+                st->events_us += loop_us() - t;
+            } else {
+                loop->events(&key);
+                now = loop_us();
+                st->events_us += now - t;
+                if(!loop->prompt.active) {
+                    loop->update();
+                    st->update_us += loop_us() - now;
+                }
+            }
+            nkeys++;
+            if(kb_block_count() != blocks) {
+                // A modal menu waited on the player, that's not lag
+                loop->nkeywait = 0;
+                break;
+            }
+            if(!check_flag(*loop->flags, GFL_RUNNING)) break;
+            if(check_flag(*loop->flags, GFL_RESTART)) break;
+            if(loop->prompt.active) break;
+        }
+        st->keys += nkeys;
+        if(!nkeys && !loop->prompt.active) {
+            t = loop_us();
+            loop->update();
+            st->update_us += loop_us() - t;
+        }
+
+        // Draw if something changed, unless the last draw was too recent - in
+        // that case sleep until it's due (a key coming in first is fine, it
+        // just gets drawn along with everything else).
+        wait = -1;
+        if(check_flag(*loop->flags, GFL_DRAW)) {
+            t = loop_us();
+            now = (t - loop->last_draw_us) / 1000; // ms since the last draw
+            wait = (now < loop->frame_ms) ? (int)(loop->frame_ms - now) : 0;
+            if(wait == 0) {
+                loop->draw();
+                if(loop->prompt.active) {
+                    game_loop_draw_prompt(loop);
+                }
+                fflush(stdout);
+                now = loop_us();
+                game_loop_key_drawn(loop, now);
+                st->draw_us += now - t;
+                st->draws++;
+                loop->last_draw_us = t;
+                wait = -1;
+            }
+        }
+        if(!check_flag(*loop->flags, GFL_DRAW)) {
+            // Nothing to draw, so the keys didn't change anything on screen
+            loop->nkeywait = 0;
+        }
+        if(check_flag(*loop->flags, GFL_RESTART)) {
+            *loop->flags &= ~GFL_RUNNING;
+        }
+        st->frames++;
+        t = loop_us() - start;
+        if(t > st->max_frame_us) st->max_frame_us = t;
+
+        if(!nkeys && check_flag(*loop->flags, GFL_RUNNING) &&
+                ((wait > 0) || !check_flag(*loop->flags, GFL_DRAW))) {
+            t = loop_us();
+            // The next timer wakes the loop up through the terminal's timer,
+            // and the poll() timeout is held to it as well in case the
+            // terminal couldn't make one (term_set_timer() does nothing then)
+            next = tw_next(&loop->timers, t / 1000);
+            if(next >= 0 && (wait < 0 || next < wait)) wait = next;
+            term_set_timer(next);
+            ev = term_wait(wait);
+            st->idle_us += loop_us() - t;
+            st->wakeups++;
+            if(check_flag(ev, TE_RESIZE)) {
+                *loop->flags |= GFL_DRAW;
+            }
+        }
+    }
+    term_set_timer(0); // Nothing left for it to wake up
+}
@@ -64,6 +64,7 @@ Highscore* create_highscores(void) {
         scores[i].datelength = 12;
         scores[i].date = malloc(sizeof(char) * 12);
         snprintf(scores[i].date, 12, "01 Jan 1970");
+        scores[i].deal = 0;
     }
     return scores;
 }
@@ -85,7 +86,7 @@ void cleanup_high_scores(Highscore *scores) {
     scores = NULL;
 }
 
-void add_new_score_chrono(Highscore *scores, int score) {
+void add_new_score_chrono(Highscore *scores, int score, uint64_t deal) {
     /*
      * Add a new score to a chronological score list.
      * (Newest score is in scores[0], oldest in scores[4])
@@ -125,6 +126,7 @@ void add_new_score_chrono(Highscore *scores, int score) {
     scores[0].datelength = strlen(strbuf) + 1;
     scores[0].date = malloc(sizeof(char) * scores[0].datelength);
     snprintf(scores[0].date, scores[0].datelength, "%s", strbuf);
+    scores[0].deal = deal;
 }
 
 /*
@@ -203,10 +205,11 @@ void scores_draw_solitaire(const char gameid) {
      * without having to repeat code. 
      * TODO
      */
-    int i = 0;
+    int i = 0, j = 0;
     char strbuf[80];
     char game[10];
     int high = 0, wins = 0;
+    uint64_t deal = 0;
     Highscore *scores = NULL;
 
     switch(gameid) {
@@ -214,6 +217,7 @@ void scores_draw_solitaire(const char gameid) {
             //Penguin
             snprintf(game,80,"Penguin ");
             high = g_settings->penguin_hs;
+            deal = g_settings->penguin_hs_deal;
             wins = g_settings->penguin_wins;
             scores = g_settings->penguin_scores;
             draw_colorstr((SCREEN_WIDTH / 2)-5,SCREEN_HEIGHT-2,
@@ -224,6 +228,7 @@ void scores_draw_solitaire(const char gameid) {
             //Klondike
             snprintf(game,80,"Klondike");
             high = g_settings->klondike_hs;
+            deal = g_settings->klondike_hs_deal;
             wins = g_settings->klondike_wins;
             scores = g_settings->klondike_scores;
             draw_colorstr((SCREEN_WIDTH / 2)-18,SCREEN_HEIGHT-2,
@@ -236,6 +241,11 @@ void scores_draw_solitaire(const char gameid) {
     }
             
     snprintf(strbuf,79,"%s High Score:    %d", game, high);
+    if(deal) {
+        // The best game is the one worth playing again
+        j = strlen(strbuf);
+        snprintf(strbuf + j, 79 - j, " (deal #%llu)", (unsigned long long)deal);
+    }
     draw_colorstr(4,8,strbuf, WHITE, BLACK);
     snprintf(strbuf,79, "               Wins:    %d", wins);
     draw_colorstr(4,9,strbuf, WHITE, BLACK);
@@ -268,6 +278,12 @@ void scores_draw_solitaire(const char gameid) {
                         scores[i].name, 
                         scores[i].date);
             }
+            if(scores[i].deal) {
+                // Tack the deal number on, so the game can be played again
+                j = strlen(strbuf);
+                snprintf(strbuf + j, 79 - j, " (deal #%llu)",
+                        (unsigned long long)scores[i].deal);
+            }
             draw_colorstr(4,11+i,strbuf, WHITE, BLACK);
         }
     }
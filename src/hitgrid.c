@@ -0,0 +1,93 @@
+/*
+* Cards
+* Copyright (C) Zach Wilder 2024
+* 
+* This file is a part of Cards
+*
+* Cards is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+* 
+* Cards is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+* 
+* You should have received a copy of the GNU General Public License
+* along with Cards.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#include <cards.h>
+
+HitGrid* create_hitgrid(void) {
+    HitGrid *hg = malloc(sizeof(HitGrid));
+    hitgrid_clear(hg);
+    hg->valid = false;
+    return hg;
+}
+
+void destroy_hitgrid(HitGrid *hg) {
+    if(!hg) return;
+    free(hg);
+}
+
+void hitgrid_clear(HitGrid *hg) {
+    if(!hg) return;
+    memset(hg->cells, 0, sizeof(hg->cells));
+}
+
+bool hitgrid_stale(HitGrid *hg, uint8_t *stamp) {
+    /* Check the layout stamp (HG_STAMPSZ bytes of whatever game state decides
+     * where things are drawn - pile sizes mostly) against the one the grid was
+     * built for. If it changed, the new stamp is kept and the caller needs to
+     * clear and rebuild the grid. */
+    if(hg->valid && (memcmp(hg->stamp, stamp, HG_STAMPSZ) == 0)) {
+        return false;
+    }
+    memcpy(hg->stamp, stamp, HG_STAMPSZ);
+    hg->valid = true;
+    return true;
+}
+
+void hitgrid_add(HitGrid *hg, int x, int y, int w, int h, char ch) {
+    /* Fill a rectangle of the grid with ch. Coordinates are the same ones the
+     * draw functions use before the screen offset is added. Later calls win
+     * where things overlap. */
+    int i = 0, j = 0;
+    if(!hg) return;
+    for(j = y; j < (y + h); j++) {
+        if((j < 0) || (j >= HG_HEIGHT)) continue;
+        for(i = x; i < (x + w); i++) {
+            if((i < 0) || (i >= HG_WIDTH)) continue;
+            hg->cells[(j * HG_WIDTH) + i] = ch;
+        }
+    }
+}
+
+void hitgrid_add_button(HitGrid *hg, Button *btn, int x, int y) {
+    // Buttons are drawn as "[c]" at x,y
+    if(!btn) return;
+    hitgrid_add(hg, x, y, 3, 1, btn->ch);
+}
+
+char hitgrid_get(HitGrid *hg, int x, int y) {
+    /* Look up a terminal cell. The grid is relative to the centered play area,
+     * so resizing the terminal doesn't need a rebuild. */
+    x -= (g_screenW / 2) - (HG_WIDTH / 2);
+    y -= (g_screenH / 2) - (HG_HEIGHT / 2);
+    if((x < 0) || (x >= HG_WIDTH) || (y < 0) || (y >= HG_HEIGHT)) return '\0';
+    return hg->cells[(y * HG_WIDTH) + x];
+}
+
+bool hitgrid_click(HitGrid *hg, KeyEvent *key) {
+    /* Turn a mouse click into the keypress for whatever was clicked on, so it
+     * goes through the game's regular events. Returns false if nothing was
+     * hit and the event should be dropped. */
+    char ch = '\0';
+    if(!hg || (key->key != KEY_MOUSE)) return false;
+    ch = hitgrid_get(hg, key->x, key->y);
+    if(!ch) return false;
+    key->key = ch;
+    key->mods = KM_NONE;
+    return true;
+}
@@ -0,0 +1,130 @@
+/*
+* Cards
+* Copyright (C) Zach Wilder 2024
+* 
+* This file is a part of Cards
+*
+* Cards is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+* 
+* Cards is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+* 
+* You should have received a copy of the GNU General Public License
+* along with Cards.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#include <cards.h>
+
+void journal_init(Journal *j, JournalEntry *entries, int cap) {
+    // entries is the caller's, room for cap records
+    j->entries = entries;
+    j->cap = cap;
+    journal_clear(j);
+}
+
+void journal_clear(Journal *j) {
+    j->start = 0;
+    j->len = 0;
+    j->pos = 0;
+    j->step = true;
+}
+
+void journal_step(Journal *j) {
+    // Whatever gets added next is a new move, as far as undo is concerned
+    j->step = true;
+}
+
+void journal_add(Journal *j, int op, int from, int to, int n, int arg) {
+    /* Write down something that was just done. Anything that had been undone
+     * is gone now (there's nothing to redo after a new move), and if the ring
+     * is full the oldest record goes, along with the rest of its step. */
+    JournalEntry *e = NULL;
+    if(!j->entries || !j->cap) return;
+    j->len = j->pos;
+    if(j->len == j->cap) {
+        do {
+            j->start = (j->start + 1) % j->cap;
+            j->len -= 1;
+        } while(j->len && !(j->entries[j->start].flags & JF_STEP));
+        j->pos = j->len;
+    }
+    e = &j->entries[(j->start + j->len) % j->cap];
+    e->op = op;
+    e->flags = j->step ? JF_STEP : JF_NONE;
+    e->from = from;
+    e->to = to;
+    e->n = n;
+    e->arg = arg;
+    j->step = false;
+    j->len += 1;
+    j->pos = j->len;
+}
+
+static void journal_apply(JournalEntry *e, Deck **decks, int *score, bool undo) {
+    // Do (or take back) one record
+    Deck *from = decks[e->from];
+    Deck *to = decks[e->to];
+    switch(e->op) {
+        case JR_MOVE:
+        case JR_MOVE_REV:
+            if(undo) {
+                splice_cards(to, to->count - e->n, from, e->op == JR_MOVE_REV);
+            } else {
+                splice_cards(from, from->count - e->n, to, e->op == JR_MOVE_REV);
+            }
+            break;
+        case JR_DRAW:
+            if(undo) {
+                draw_cards(to, from, e->n); // Drawing them back undoes it
+            } else {
+                draw_cards(from, to, e->n);
+            }
+            break;
+        case JR_FLIP:
+            if(e->n >= from->count) break;
+            if(undo) {
+                remove_flag(&from->cards[e->n]->flags, CD_UP);
+            } else {
+                engage_flag(&from->cards[e->n]->flags, CD_UP);
+            }
+            break;
+        case JR_SWAP:
+            swap_cards(from, e->n, to, e->arg);
+            break;
+        case JR_SCORE:
+            *score += undo ? -e->arg : e->arg;
+            break;
+        default: break;
+    }
+}
+
+bool journal_undo(Journal *j, Deck **decks, int *score) {
+    // Take back the last move, returns false if there's nothing to undo
+    JournalEntry *e = NULL;
+    if(!j->pos) return false;
+    do {
+        j->pos -= 1;
+        e = &j->entries[(j->start + j->pos) % j->cap];
+        journal_apply(e, decks, score, true);
+    } while(j->pos && !(e->flags & JF_STEP));
+    j->step = true;
+    return true;
+}
+
+bool journal_redo(Journal *j, Deck **decks, int *score) {
+    // Do the last undone move again, returns false if there isn't one
+    JournalEntry *e = NULL;
+    if(j->pos == j->len) return false;
+    do {
+        e = &j->entries[(j->start + j->pos) % j->cap];
+        journal_apply(e, decks, score, false);
+        j->pos += 1;
+    } while((j->pos < j->len) &&
+            !(j->entries[(j->start + j->pos) % j->cap].flags & JF_STEP));
+    j->step = true;
+    return true;
+}
@@ -29,16 +29,26 @@ bool klondike_init(void) {
      * the user wants to return to the main menu, or quit the game entirely.
      */
     int i = 0;
+    unsigned long allocs = 0;
     bool ret_to_main = false;
-    if(g_klondike) klondike_cleanup();
+    // Anything carved out for this deal that didn't fit in the arena
+    allocs = arena_heap_allocs();
 
-    // Allocate memory for decks/buttons
-    g_klondike = create_solitaire(KL_NUM_DECKS);
+    // A restart reuses the game that's already there, it's just emptied out
+    if(g_klondike) {
+        reset_solitaire(g_klondike);
+    } else {
+        // Allocate memory for decks/buttons
+        g_klondike = create_solitaire(KL_NUM_DECKS);
+    }
 
-    // Register events/update/draw
-    g_klondike->events = &klondike_events;
-    g_klondike->update = &klondike_update;
-    g_klondike->draw = &klondike_draw;
+    // Register events/update/draw/layout with the game loop
+    g_klondike->loop->name = "klondike";
+    g_klondike->loop->events = &klondike_events;
+    g_klondike->loop->update = &klondike_update;
+    g_klondike->loop->draw = &klondike_draw;
+    g_klondike->loop->click = &klondike_click;
+    g_klondike->layout = &klondike_layout;
 
     // Put the buttons in the right spot
     g_klondike->btns[KL_STOCK]->x = 3;
@@ -56,12 +66,15 @@ bool klondike_init(void) {
         g_klondike->btns[KL_FND_H + i]->ch = '1' + i;
     }
 
-    // Put 52 cards in the stock, and shuffle it
-    fill_deck(g_klondike->decks[KL_STOCK]);
-    shuffle_deck(g_klondike->decks[KL_STOCK]);
+    // Put the 52 cards in the shoe in the stock, and shuffle it
+    fill_deck_from_shoe(g_klondike->decks[KL_STOCK], g_klondike->shoe);
+    g_klondike->deal = take_next_deal();
+    shuffle_deal(g_klondike->decks[KL_STOCK], &g_klondike->rng, g_klondike->deal);
 
     // Deal the cards, draw the cards, enter the loop
     klondike_deal();
+    g_klondike->loop->stats.deals += 1;
+    g_klondike->loop->stats.deal_allocs = arena_heap_allocs() - allocs;
     klondike_update();
     klondike_draw();
     klondike_loop();
@@ -85,41 +98,47 @@ void klondike_cleanup(void) {
 }
 
 void klondike_deal(void) {
+    klondike_deal_decks(g_klondike->decks);
+}
+
+void klondike_deal_decks(Deck **decks) {
+    // Deal from the stock onto the tableaus of any set of Klondike decks
     int i = 0, j = 0;
     Card *tmp = NULL;
     for(i = 0; i < 7; i++) {
         j = i + 1;
         // Draw cards from the deck to put on the tableau
-        draw_cards(g_klondike->decks[KL_STOCK],g_klondike->decks[KL_TAB_B + i], j);
+        draw_cards(decks[KL_STOCK],decks[KL_TAB_B + i], j);
 
         // Turn the top card (last card) faceup
-        tmp = g_klondike->decks[KL_TAB_B + i]->cards;
-        while(tmp->next) {
-            tmp = tmp->next;
-        }
+        tmp = get_last_card(decks[KL_TAB_B + i]);
         engage_flag(&(tmp->flags), CD_UP);
     }
 }
 
 void klondike_loop(void) {
     // Main loop
-    solitaire_loop(g_klondike);
+    game_loop_run(g_klondike->loop);
     // Score check here... If score is new high score, save it
     if(g_klondike->score > g_settings->klondike_hs) {
         g_settings->klondike_hs = g_klondike->score;
+        g_settings->klondike_hs_deal = g_klondike->deal;
     }
     if(g_klondike->score) {
         g_settings->klondike_last = g_klondike->score;
         add_new_score_chrono(g_settings->klondike_scores,
-                g_klondike->score);
+                g_klondike->score, g_klondike->deal);
     }
     save_settings();
 }
 
-void klondike_events(void) {
+bool klondike_click(KeyEvent *key) {
+    return solitaire_click(g_klondike, key);
+}
+
+void klondike_events(KeyEvent *key) {
     bool redraw = false;
-    char ch = kb_get_char();
-    switch(ch) {
+    switch(key->key) {
         case 'A':
         case 'a': toggle_button(g_klondike->btns[KL_WASTE]); 
                   redraw = true; 
@@ -168,7 +187,13 @@ void klondike_events(void) {
         case 'm': toggle_button(g_klondike->btns[KL_STOCK]);
                   redraw = true;
                   break;
-        case 27: 
+        case 'U':
+        case 'u': solitaire_undo(g_klondike);
+                  break;
+        case 'R':
+        case 'r': solitaire_redo(g_klondike);
+                  break;
+        case KEY_ESC:
         case 'q':
                   solitaire_pause(g_klondike);
                   redraw = true; 
@@ -106,28 +106,22 @@ void klondike_draw(void) {
     }
 
     // Draw Stock
-    if(g_klondike->decks[KL_STOCK]->cards) {
+    if(g_klondike->decks[KL_STOCK]->count) {
         pt_card_back(3+xo,1+yo);
     } else {
         pt_card_space(3+xo,1+yo);
     }
 
     // Draw waste
-    if(g_klondike->decks[KL_WASTE]->cards) {
+    if(g_klondike->decks[KL_WASTE]->count) {
         // Draw the last three cards on the waste pile
         // This is kinda ugly, but it works so... its ok?
         x = 8;
         deck = g_klondike->decks[KL_WASTE];
+        // (get_card_at gives back NULL past the start of the deck)
         cda = get_card_at(deck, deck->count - 3); //Third to last
         cdb = get_card_at(deck, deck->count - 2); //Second to last
         cdc = get_card_at(deck, deck->count - 1); //Last
-        /*
-        cdc = get_last_card(deck); // Last
-        if(cdc->prev) cdb = cdc->prev; // Second to last
-        if(cdb->prev) cda = cdb->prev; // Third to last
-        */
-        if((cda == cdb) || (cda == cdc)) cda = NULL; //In case it loops around?
-        if((cdb == cdc)) cdb = NULL; // Same
         if(cda && cdb && cdc) {
             pt_card_left(x+xo,1+yo,cda);
             pt_card_left(x+xo+1,1+yo,cdb);
@@ -143,24 +137,19 @@ void klondike_draw(void) {
     // Draw Tableaus
     for(i = 0; i < 7; i++) {
         deck = g_klondike->decks[KL_TAB_B + i];
-        if(deck->cards) {
-            cards = deck->cards;
-            j = 0;
+        if(deck->count) {
             // Print the tops of all cards, except last
-            while(cards->next) {
+            for(j = 0; j < deck->count - 1; j++) {
+                cards = deck->cards[j];
                 if(check_flag(cards->flags, CD_UP)) {
                     pt_card_top(22+(5*i)+xo,1+j+yo,cards);
                 } else {
                     pt_card_back(22+(5*i)+xo,1+j+yo);
                 }
-                j++;
-                cards = cards->next;
-            }
-            // Print the last card (which is always face up)
-            if(!check_flag(cards->flags, CD_UP)) {
-                engage_flag(&(cards->flags),CD_UP);
-                g_klondike->score += 5; // Flipping over a tab card is 5pts
             }
+            // Print the last card (which is always face up, see
+            // klondike_update())
+            cards = deck->cards[j];
             pt_card(22+(5*i)+xo,1+j+yo,cards);
         }
     }
@@ -192,7 +181,7 @@ void klondike_draw(void) {
     }
 
     // Draw msg
-    if(g_klondike->msg) {
+    if(g_klondike->msg[0]) {
         scr_pt_clr(xo, 21+yo, WHITE, BLACK, "%s",
                 g_klondike->msg);
     }
@@ -203,13 +192,34 @@ void klondike_draw(void) {
 
     // Draw status
     scr_pt_clr(xo,23+yo,BRIGHT_BLACK,BLACK,
-            "High score: %d. Last score: %d. Stock: %d. Waste: %d.", 
+            "High score: %d. Last score: %d. Stock: %d. Waste: %d. Deal #%llu.", 
             g_settings->klondike_hs,
             g_settings->klondike_last,
             g_klondike->decks[KL_STOCK]->count,
-            g_klondike->decks[KL_WASTE]->count);
+            g_klondike->decks[KL_WASTE]->count,
+            (unsigned long long)g_klondike->deal);
 
     // Reset drawing functions
     //scr_reset();
     g_klondike->flags &= ~GFL_DRAW;
 }
+
+void klondike_layout(HitGrid *hits) {
+    /* Mouse targets, same spots as klondike_draw() above. Clicking a pile
+     * (anywhere on its cards) is the same as pressing its button. */
+    int i = 0, h = 0;
+    Button **btns = g_klondike->btns;
+    for(i = 0; i < KL_NUM_DECKS; i++) {
+        hitgrid_add_button(hits, btns[i], btns[i]->x, btns[i]->y);
+    }
+    hitgrid_add(hits, 3, 1, 4, 4, btns[KL_STOCK]->ch);
+    hitgrid_add(hits, 8, 1, 6, 4, btns[KL_WASTE]->ch);
+    for(i = 0; i < 7; i++) {
+        h = g_klondike->decks[KL_TAB_B + i]->count + 3;
+        if(h < 4) h = 4;
+        hitgrid_add(hits, 22 + (5*i), 1, 4, h, btns[KL_TAB_B + i]->ch);
+    }
+    for(i = 0; i < 4; i++) {
+        hitgrid_add(hits, 61 + (5*i), 1, 4, 4, btns[KL_FND_H + i]->ch);
+    }
+}
@@ -0,0 +1,196 @@
+/*
+* Cards
+* Copyright (C) Zach Wilder 2024
+* 
+* This file is a part of Cards
+*
+* Cards is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+* 
+* Cards is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+* 
+* You should have received a copy of the GNU General Public License
+* along with Cards.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#include <cards.h>
+
+/*****
+ * The Klondike move generator, see klondike.h. The rules are the same ones
+ * klondike_update() and friends go by when the buttons are pressed - the top
+ * of the waste or the last card of a tableau can go on its foundation or on
+ * a tableau, any part of a tableau's face up run can go on another tableau,
+ * only a king goes on an empty tableau, and the stock is drawn from or (when
+ * it's empty) the waste is turned back over onto it.
+ *
+ * Nothing here searches for anything. A foundation only ever holds its own
+ * suite from the ace up, so a card can go on it if it has rank - 1 cards. The
+ * face up run of a tableau goes down one rank at a time, so the only card in
+ * it that could go on another tableau is a known number of cards in from the
+ * start. The rest is the card tables, see init_card_tables().
+ *
+ * Moving a king that's already at the bottom of a tableau to an empty one
+ * doesn't get anywhere, so those aren't counted. That leaves at most 8 for
+ * the waste (a king on its foundation and 7 empty tableaus), 7 tableaus to
+ * foundations, 14 runs to tableaus that have cards (each last card takes one
+ * of two cards), 12 kings to empty tableaus (4 kings, and they need tableaus
+ * to be on) and 1 for the stock - 42, less than KL_MOVES_MAX.
+ *****/
+
+// Foundation for each suite, in card id order (H, S, C, D)
+static const uint8_t s_fnd_for_suite[4] = {
+    KL_FND_H, KL_FND_S, KL_FND_C, KL_FND_D
+};
+
+static int klondike_card_id(Card *card) {
+    return card_id(card->flags);
+}
+
+static int klondike_first_up(Deck *tab) {
+    // Where the face up run starts, the face up cards are all on the end
+    int i = tab->count;
+    while(i && check_flag(tab->cards[i - 1]->flags, CD_UP)) i--;
+    return i;
+}
+
+static bool klondike_to_fnd(Deck **decks, int id) {
+    // Can the card go on its foundation?
+    return decks[s_fnd_for_suite[id / 13]]->count == g_cardtab.rank[id] - 1;
+}
+
+static void klondike_add_move(KlondikeMove *moves, int *n, int kind, int from,
+        int to, int count) {
+    KlondikeMove *m = &moves[*n];
+    m->kind = kind;
+    m->from = from;
+    m->to = to;
+    m->n = count;
+    m->flips = KLF_NONE;
+    *n += 1;
+}
+
+int klondike_moves(Deck **decks, KlondikeMove *moves) {
+    int n = 0, s = 0, t = 0, i = 0, id = 0, first = 0;
+    int up[7]; // Start of the face up run on each tableau
+    int last[7]; // Card id of the last card on each tableau, -1 if it's empty
+    Deck *stock = decks[KL_STOCK], *waste = decks[KL_WASTE], *tab = NULL;
+
+    for(t = 0; t < 7; t++) {
+        tab = decks[KL_TAB_B + t];
+        up[t] = klondike_first_up(tab);
+        last[t] = tab->count ? klondike_card_id(tab->cards[tab->count - 1]) : -1;
+    }
+
+    // Top of the waste
+    if(waste->count) {
+        id = klondike_card_id(waste->cards[waste->count - 1]);
+        if(klondike_to_fnd(decks, id)) {
+            klondike_add_move(moves, &n, KLM_WASTE_FND, KL_WASTE,
+                    s_fnd_for_suite[id / 13], 1);
+        }
+        for(t = 0; t < 7; t++) {
+            if((last[t] < 0) ? (g_cardtab.rank[id] == 13) :
+                    ((g_cardtab.stacks[last[t]] >> id) & 1)) {
+                klondike_add_move(moves, &n, KLM_WASTE_TAB, KL_WASTE,
+                        KL_TAB_B + t, 1);
+            }
+        }
+    }
+
+    // Tableaus
+    for(s = 0; s < 7; s++) {
+        tab = decks[KL_TAB_B + s];
+        if(up[s] >= tab->count) continue;
+        if(klondike_to_fnd(decks, last[s])) {
+            klondike_add_move(moves, &n, KLM_TAB_FND, KL_TAB_B + s,
+                    s_fnd_for_suite[last[s] / 13], 1);
+        }
+        first = klondike_card_id(tab->cards[up[s]]);
+        for(t = 0; t < 7; t++) {
+            if(t == s) continue;
+            if(last[t] < 0) {
+                // Only a king, and only if there's something under it
+                if(up[s] && (g_cardtab.rank[first] == 13)) {
+                    klondike_add_move(moves, &n, KLM_TAB_TAB, KL_TAB_B + s,
+                            KL_TAB_B + t, tab->count - up[s]);
+                }
+                continue;
+            }
+            // The card one rank lower than the last card on t
+            i = up[s] + g_cardtab.rank[first] - g_cardtab.rank[last[t]] + 1;
+            if((i < up[s]) || (i >= tab->count)) continue;
+            if((g_cardtab.stacks[last[t]] >>
+                        klondike_card_id(tab->cards[i])) & 1) {
+                klondike_add_move(moves, &n, KLM_TAB_TAB, KL_TAB_B + s,
+                        KL_TAB_B + t, tab->count - i);
+            }
+        }
+    }
+
+    // Stock
+    if(stock->count) {
+        klondike_add_move(moves, &n, KLM_DRAW, KL_STOCK, KL_WASTE,
+                (stock->count < KL_DRAW) ? stock->count : KL_DRAW);
+    } else if(waste->count) {
+        klondike_add_move(moves, &n, KLM_RECYCLE, KL_WASTE, KL_STOCK,
+                waste->count);
+    }
+    return n;
+}
+
+void klondike_apply(Deck **decks, KlondikeMove *move) {
+    /* Make a move from klondike_moves(). Cards come off the waste face down,
+     * so (like klondike_update() does) the card is turned up if it lands on a
+     * tableau, and so is the card a run or card leaves on the end of a
+     * tableau. move->flips remembers which, for klondike_unapply(). */
+    Deck *from = decks[move->from], *to = decks[move->to];
+    Card *card = NULL;
+    move->flips = KLF_NONE;
+    switch(move->kind) {
+        case KLM_DRAW:
+        case KLM_RECYCLE:
+            draw_cards(from, to, move->n);
+            return;
+        default:
+            splice_cards(from, from->count - move->n, to, false);
+            break;
+    }
+    if(move->to <= KL_TAB_H) {
+        card = to->cards[to->count - move->n];
+        if(!check_flag(card->flags, CD_UP)) {
+            engage_flag(&card->flags, CD_UP);
+            move->flips |= KLF_CARD;
+        }
+    }
+    if((move->from != KL_WASTE) && from->count) {
+        card = from->cards[from->count - 1];
+        if(!check_flag(card->flags, CD_UP)) {
+            engage_flag(&card->flags, CD_UP);
+            move->flips |= KLF_FROM;
+        }
+    }
+}
+
+void klondike_unapply(Deck **decks, KlondikeMove *move) {
+    // Take back the last klondike_apply()
+    Deck *from = decks[move->from], *to = decks[move->to];
+    switch(move->kind) {
+        case KLM_DRAW:
+        case KLM_RECYCLE:
+            draw_cards(to, from, move->n);
+            return;
+        default:
+            break;
+    }
+    if(move->flips & KLF_FROM) {
+        remove_flag(&from->cards[from->count - 1]->flags, CD_UP);
+    }
+    if(move->flips & KLF_CARD) {
+        remove_flag(&to->cards[to->count - move->n]->flags, CD_UP);
+    }
+    splice_cards(to, to->count - move->n, from, false);
+}
@@ -20,25 +20,33 @@
 
 #include <cards.h>
 
+void klondike_another_game(char answer, void *data) {
+    // Answer to the prompt when the game is won
+    if(answer == 'Y') {
+        g_klondike->flags |= GFL_RESTART;
+    } else {
+        g_klondike->flags |= GFL_QTOMAIN;
+        g_klondike->flags &= ~GFL_RUNNING;
+    }
+}
+
 void klondike_update(void) {
     int i = 0, count = 0;
+    CardSet found = 0;
+    Card *card = NULL;
     int id_a = 0, id_b = 0;
     int cflags_a = 0, cflags_b = 0;
 
     // Check win condition
     if(check_flag(g_klondike->flags, GFL_WIN)) {
         // None of the rest of update needs to run
-        g_klondike->flags |= GFL_DRAW;
-        g_klondike->draw();
-        if(solitaire_prompt("Another game? (y/n): ") == 'Y') {
-            g_klondike->flags |= GFL_RESTART;
-        } else {
-            g_klondike->flags |= GFL_QTOMAIN;
-            g_klondike->flags &= ~GFL_RUNNING;
-        }
+        solitaire_prompt(g_klondike, &klondike_another_game, "Another game? (y/n): ");
         return;
     }
 
+    // Anything this key does to the cards is one move, for undo
+    journal_step(&g_klondike->journal);
+
     // Count the selected buttons
     count = 0;
     for(i = 0; i < KL_NUM_DECKS; i++) {
@@ -59,9 +67,12 @@ void klondike_update(void) {
             g_klondike->btns[id_a]->selected = false; // Deselect button
             // Draw cards from stock to waste
             if(g_klondike->decks[KL_STOCK]->count) {
-                draw_cards(g_klondike->decks[KL_STOCK],g_klondike->decks[KL_WASTE],3);
+                solitaire_draw(g_klondike, g_klondike->decks[KL_STOCK],
+                        g_klondike->decks[KL_WASTE], KL_DRAW);
             } else {
-                add_deck(g_klondike->decks[KL_WASTE],g_klondike->decks[KL_STOCK]);
+                solitaire_draw(g_klondike, g_klondike->decks[KL_WASTE],
+                        g_klondike->decks[KL_STOCK],
+                        g_klondike->decks[KL_WASTE]->count);
             }
             g_klondike->flags |= GFL_DRAW;
         } else {
@@ -76,10 +87,10 @@ void klondike_update(void) {
         }
 
         //Check move here
-        if(g_klondike->toref->count && g_klondike->toref->cards) {
+        if(g_klondike->toref->count) {
             cflags_a = get_last_card(g_klondike->toref)->flags;
         }
-        if(g_klondike->fromref->count && g_klondike->fromref->cards) {
+        if(g_klondike->fromref->count) {
             cflags_b = get_last_card(g_klondike->fromref)->flags;
         }
         if(g_klondike->toref->id == KL_WASTE) {
@@ -100,13 +111,17 @@ void klondike_update(void) {
             // Attempting to move card to a tableau
             if(g_klondike->fromref->id == KL_WASTE) {
                 if(klondike_valid_move(cflags_a,cflags_b)) {
-                    move_last_card_to_deck(g_klondike->fromref, g_klondike->toref);
+                    solitaire_move(g_klondike, g_klondike->fromref,
+                            g_klondike->fromref->count - 1, g_klondike->toref,
+                            false);
                     solitaire_msg(g_klondike,"5 points!");
-                    g_klondike->score += 5;
+                    solitaire_score(g_klondike, 5);
                     g_klondike->flags |= GFL_DRAW;
-                }else if (!g_klondike->toref->cards && 
+                }else if (!g_klondike->toref->count && 
                         (check_flag(cflags_b, CD_K))) {
-                    move_last_card_to_deck(g_klondike->fromref, g_klondike->toref);
+                    solitaire_move(g_klondike, g_klondike->fromref,
+                            g_klondike->fromref->count - 1, g_klondike->toref,
+                            false);
                     solitaire_msg(g_klondike,NULL);
                     g_klondike->flags |= GFL_DRAW;
                 }
@@ -122,6 +137,18 @@ void klondike_update(void) {
         g_klondike->toref = NULL;
     }
 
+    // The last card on each tableau is always face up, flipping one over
+    // is 5 points
+    for(i = KL_TAB_B; i <= KL_TAB_H; i++) {
+        card = get_last_card(g_klondike->decks[i]);
+        if(card && !check_flag(card->flags, CD_UP)) {
+            solitaire_flip(g_klondike, g_klondike->decks[i],
+                    g_klondike->decks[i]->count - 1);
+            solitaire_score(g_klondike, 5);
+            g_klondike->flags |= GFL_DRAW;
+        }
+    }
+
     // Activate/deactivate waste button
     if(g_klondike->decks[KL_WASTE]->count) {
         g_klondike->btns[KL_WASTE]->active = true;
@@ -130,11 +157,11 @@ void klondike_update(void) {
     }
     // Check win condition
     if(!check_flag(g_klondike->flags, GFL_WIN)) {
-        count = 0;
+        found = 0;
         for(i = KL_FND_H; i <= KL_FND_S; i++) {
-            count += count_cards(g_klondike->decks[i]->cards); 
+            found |= g_klondike->decks[i]->set;
         }
-        if(count == 52) {
+        if(found == CARDSET_ALL) {
             // all 52 cards are on the foundations
             g_klondike->flags |= GFL_WIN;
             g_settings->klondike_wins += 1;
@@ -150,27 +177,28 @@ void klondike_update(void) {
 }
 
 void klondike_check_sequence(void) {
-    Card *card = NULL, *tocard = NULL, *prev = NULL;
+    Deck *from = g_klondike->fromref;
+    Card *card = NULL, *tocard = NULL;
     bool valid_move = false;
+    int i = 0;
 
     // The first visible card in a tableau is the highest in sequence
-    card = g_klondike->fromref->cards;
-    if(!card) return; // Can't move nothin' from nothin'
-    while(card) {
-        if(check_flag(card->flags, CD_UP)) break;
-        card = card->next;
+    if(!from->count) return; // Can't move nothin' from nothin'
+    for(i = 0; i < from->count; i++) {
+        if(check_flag(from->cards[i]->flags, CD_UP)) break;
     }
-    if(!card) {
+    if(i == from->count) {
         // If for some reason it didn't find ANY face up card, grab the last
-        card = get_last_card(g_klondike->fromref);
+        i = from->count - 1;
     }
+    card = from->cards[i];
 
     // See how many cards are in the sequence
     // Prompt the user to see how many they want to move
     // Set card to the first card the user wants to move
     
     // Check last card of "to", to see if this move is valid
-    if(!g_klondike->toref->cards) {
+    if(!g_klondike->toref->count) {
         //Can only move a king to an empty spot
         if(check_flag(card->flags, CD_K)) {
             // Valid, do it
@@ -178,47 +206,20 @@ void klondike_check_sequence(void) {
         }
     } else {
         tocard = get_last_card(g_klondike->toref);
-        // If this fails, we need to check card->next until card->next is NULL
-        // to see if there is a valid move
-        if(klondike_valid_move(tocard->flags, card->flags)) {
-            // Valid, do it
-            valid_move = true;
-        } else {
-            // Check the next cards
-            while(card->next) {
-                card = card->next;
-                if(klondike_valid_move(tocard->flags,card->flags)) {
-                    valid_move = true;
-                    break;
-                }
+        // If this fails, we need to check the cards after it to see if there
+        // is a valid move
+        for(; i < from->count; i++) {
+            card = from->cards[i];
+            if(klondike_valid_move(tocard->flags,card->flags)) {
+                valid_move = true;
+                break;
             }
         }
     }
 
-    // Find card BEFORE card in "from" deck (next to last card)
+    // Move card, and everything on top of it, over to "to"
     if(valid_move) {
-        prev = g_klondike->fromref->cards;
-        if(prev != card) {
-            // card isn't the only one in "from" deck
-            while(prev->next != card) {
-                prev = prev->next;
-            }
-            // prev is next to last card in fromref
-            prev->next = NULL; //Sever that chain!
-            g_klondike->fromref->count = count_cards(g_klondike->fromref->cards);
-        } else {
-            //prev == card
-            //card is the only one in "from" deck
-            g_klondike->fromref->cards = NULL;
-        }
-        if(tocard) {
-            // Reattach that chain!
-            tocard->next = card;
-            card->prev = tocard; // Think this fixes the double llist issue
-        } else {
-            g_klondike->toref->cards = card;
-        }
-        g_klondike->toref->count = count_cards(g_klondike->toref->cards);
+        solitaire_move(g_klondike, from, i, g_klondike->toref, false);
         g_klondike->flags |= GFL_DRAW;
     }
 }
@@ -230,18 +231,17 @@ void klondike_fnd_move(void) {
     bool valid_move = false;
 
     // Get flags on "from" card
-    if(g_klondike->fromref->count && g_klondike->fromref->cards) {
+    if(g_klondike->fromref->count) {
         cflags_b = get_last_card(g_klondike->fromref)->flags;
     }
 
     // Loop through foundations
     for(i = KL_FND_H; i <= KL_FND_S; i++) {
         if(valid_move) break; //Don't continue if we already found a valid move
-        if(g_klondike->decks[i]->cards) {
+        if(g_klondike->decks[i]->count) {
             //This foundation has a card, see if the from card can be moved there
             cflags_a = get_last_card(g_klondike->decks[i])->flags;
-            if(card_same_suite(cflags_a,cflags_b) &&
-                    card_in_asc_sequence(cflags_b,cflags_a)) {
+            if(card_follows(cflags_b,cflags_a)) {
                 g_klondike->toref = g_klondike->decks[i];
                 valid_move = true;
             }
@@ -284,13 +284,15 @@ void klondike_fnd_move(void) {
     }
     if(valid_move) {
         //Move card
-        g_klondike->score += 10; // Moving a card to a foundation is 10pts
-        move_last_card_to_deck(g_klondike->fromref, g_klondike->toref);
+        solitaire_score(g_klondike, 10); // Moving a card to a foundation is 10pts
+        solitaire_move(g_klondike, g_klondike->fromref,
+                g_klondike->fromref->count - 1, g_klondike->toref, false);
         solitaire_msg(g_klondike,"10 points!");
         g_klondike->flags |= GFL_DRAW;
     }
 }
 
 bool klondike_valid_move(int a, int b) {
-    return (card_in_asc_sequence(a,b) && card_alt_color(a,b));
+    // Can card 'b' go on card 'a'? One lower and the other color.
+    return card_stacks_on(a,b);
 }
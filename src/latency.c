@@ -0,0 +1,69 @@
+/*
+* Cards
+* Copyright (C) Zach Wilder 2024
+* 
+* This file is a part of Cards
+*
+* Cards is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+* 
+* Cards is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+* 
+* You should have received a copy of the GNU General Public License
+* along with Cards.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#include <cards.h>
+
+static int lh_index(long v) {
+    int msb = 0, shift = 0;
+    if(v < LH_SUB) return (int)v;
+    msb = 63 - __builtin_clzll((unsigned long long)v);
+    shift = msb - LH_SUBBITS;
+    return ((shift + 1) * LH_SUB) + (int)((v >> shift) & (LH_SUB - 1));
+}
+
+static long lh_value(int i) {
+    // Highest value that lands in bucket i
+    int shift = (i / LH_SUB) - 1;
+    if(i < LH_SUB) return i;
+    return ((long)(LH_SUB + (i % LH_SUB)) << shift) + ((1L << shift) - 1);
+}
+
+void lh_reset(LatencyHist *h) {
+    memset(h->counts, 0, sizeof(h->counts));
+    h->total = 0;
+    h->max = 0;
+}
+
+void lh_record(LatencyHist *h, long us) {
+    int i = 0;
+    if(us < 0) us = 0;
+    i = lh_index(us);
+    if(i >= LH_BUCKETS) i = LH_BUCKETS - 1;
+    h->counts[i]++;
+    h->total++;
+    if(us > h->max) h->max = us;
+}
+
+long lh_percentile(LatencyHist *h, double pct) {
+    /* Value at or under which pct percent of the recorded values fall
+     * (rounded up to the end of its bucket, but never past the max). */
+    unsigned long want = 0, seen = 0;
+    long v = 0;
+    int i = 0;
+    if(!h->total) return 0;
+    want = (unsigned long)((pct / 100.0) * h->total + 0.5);
+    if(want < 1) want = 1;
+    if(want > h->total) want = h->total;
+    for(i = 0; i < LH_BUCKETS; i++) {
+        seen += h->counts[i];
+        if(seen >= want) break;
+    }
+    v = lh_value(i);
+    return (v < h->max) ? v : h->max;
+}
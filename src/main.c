@@ -20,7 +20,30 @@
 #include <cards.h>
 
 int main(int argc, char **argv) {
-    init_genrand(time(NULL)); // Seed the prng
+    int i = 0;
+    uint64_t deal = 0;
+    rng_init_entropy(&g_rng); // Seed the default random number stream
+    init_card_tables(); // Work out rank/suite/rules for each card
+    if((argc > 1) && (strcmp(argv[1], "--bench") == 0)) {
+        return run_bench(); // Microbenchmarks, no terminal needed
+    }
+    if((argc > 1) && (strcmp(argv[1], "--shuffle-test") == 0)) {
+        // Check the shuffle is fair, optionally with how many shuffles and
+        // the seed to use
+        return run_shuffle_test((argc > 2) ? atol(argv[2]) : 0,
+                (argc > 3) ? strtoul(argv[3], NULL, 10) : 0);
+    }
+    for(i = 1; i < argc; i++) {
+        if(strcmp(argv[i], "--deal") != 0) continue;
+        // Play a specific deal, the first game started will use it
+        if((i + 1 >= argc) || !parse_deal(argv[i + 1], &deal)) {
+            fprintf(stderr, "%s: --deal needs a deal number, 1 to %llu\n",
+                    argv[0], (unsigned long long)UINT64_MAX);
+            return 1;
+        }
+        set_next_deal(deal);
+        i++;
+    }
     term_init(); // Initialize the terminal
     init_screenbuf(); // Initialize the global screen buffer
     clear_screen(g_screenbuf); // Clear the screenbuf
@@ -23,6 +23,9 @@ void main_menu(void) {
     int xo = (g_screenW / 2) - (SCREEN_WIDTH / 2);
     int yo = (g_screenH / 2) - (SCREEN_HEIGHT / 2);
     char ch = '\0';
+    char *str = NULL;
+    uint64_t deal = 0;
+    bool baddeal = false; // The last deal typed in wasn't a number
     while(ch != 'q') {
         scr_clear(); // Clear everything off the terminal screen
         // Screen buffer drawing
@@ -31,7 +34,7 @@ void main_menu(void) {
                 "[k] - Klondike        [p] - Penguin");
         
         draw_str((SCREEN_WIDTH/2)-20,9,
-                "[c] - Cribbage");
+                "[c] - Cribbage        [d] - Pick a Deal");
         
         draw_str((SCREEN_WIDTH/2)-20,11,
                 "[h] - High Scores     [o] - Card Settings");
@@ -39,6 +42,15 @@ void main_menu(void) {
                 "[?] - Help            [q] - Quit");
         draw_screen(g_screenbuf);
         // Terminal drawing
+        if(baddeal) {
+            scr_pt_clr((SCREEN_WIDTH/2)-20+xo,14+yo,BRIGHT_BLACK,BLACK,
+                    "That's not a deal number (1 or more).");
+            baddeal = false;
+        } else if(peek_next_deal()) {
+            scr_pt_clr((SCREEN_WIDTH/2)-20+xo,14+yo,BRIGHT_BLACK,BLACK,
+                    "Next game will be deal #%llu.",
+                    (unsigned long long)peek_next_deal());
+        }
         pt_card_title((SCREEN_WIDTH/2)-12+xo,1+yo,"Cards!");
         scr_pt_clr((SCREEN_WIDTH / 2)-9+xo,(SCREEN_HEIGHT - 1)+yo,
                 BRIGHT_BLACK,BLACK, "\u00A9 Zach Wilder 2024");
@@ -53,6 +65,21 @@ void main_menu(void) {
             case 'c':
                 if(!cribbage_init()) ch = 'q';
                 break;
+            case 'd':
+                // Ask for a deal number, the next game started uses it
+                scr_pt_clr((SCREEN_WIDTH/2)-20+xo,14+yo,WHITE,BLACK,
+                        "Deal number:                              ");
+                str = kb_get_str_at((SCREEN_WIDTH/2)-7+xo,14+yo,21);
+                if(str) {
+                    if(parse_deal(str, &deal)) {
+                        set_next_deal(deal);
+                    } else {
+                        baddeal = true;
+                    }
+                    free(str);
+                    str = NULL;
+                }
+                break;
             case 'h':
                 high_scores();
                 break;
@@ -42,20 +42,28 @@
 */
 
 #include <mt19937.h>
+#include <rng.h>
 
 /* Period parameters */  
-#define N 624
+#define N MT_N
 #define M 397
 #define MATRIX_A 0x9908b0dfUL   /* constant vector a */
 #define UPPER_MASK 0x80000000UL /* most significant w-r bits */
 #define LOWER_MASK 0x7fffffffUL /* least significant r bits */
 
-static unsigned long mt[N]; /* the array for the state vector  */
-static int mti=N+1; /* mti==N+1 means mt[N] is not initialized */
+/*
+ * The state used to be a static array here, so there was only ever one
+ * stream. It lives in an MtState now (st->mt is the state vector, st->mti
+ * where it's at, N+1 means not initialized) so there can be as many as
+ * needed - see rng.h. The original functions below use the default one in
+ * g_rng.
+ */
 
 /* initializes mt[N] with a seed */
-void init_genrand(unsigned long s)
+void mt_seed(MtState *st, unsigned long s)
 {
+    uint32_t *mt = st->mt;
+    int mti;
     mt[0]= s & 0xffffffffUL;
     for (mti=1; mti<N; mti++) {
         mt[mti] = 
@@ -67,16 +75,18 @@ void init_genrand(unsigned long s)
         mt[mti] &= 0xffffffffUL;
         /* for >32 bit machines */
     }
+    st->mti = mti;
 }
 
 /* initialize by an array with array-length */
 /* init_key is the array for initializing keys */
 /* key_length is its length */
 /* slight change for C++, 2004/2/26 */
-void init_by_array(unsigned long init_key[], int key_length)
+void mt_seed_by_array(MtState *st, unsigned long init_key[], int key_length)
 {
+    uint32_t *mt = st->mt;
     int i, j, k;
-    init_genrand(19650218UL);
+    mt_seed(st, 19650218UL);
     i=1; j=0;
     k = (N>key_length ? N : key_length);
     for (; k; k--) {
@@ -99,17 +109,18 @@ void init_by_array(unsigned long init_key[], int key_length)
 }
 
 /* generates a random number on [0,0xffffffff]-interval */
-unsigned long genrand_int32(void)
+uint32_t mt_next(MtState *st)
 {
+    uint32_t *mt = st->mt;
     unsigned long y;
-    static unsigned long mag01[2]={0x0UL, MATRIX_A};
+    static const unsigned long mag01[2]={0x0UL, MATRIX_A};
     /* mag01[x] = x * MATRIX_A  for x=0,1 */
 
-    if (mti >= N) { /* generate N words at one time */
+    if (st->mti >= N) { /* generate N words at one time */
         int kk;
 
-        if (mti == N+1)   /* if init_genrand() has not been called, */
-            init_genrand(5489UL); /* a default initial seed is used */
+        if (st->mti == N+1)   /* if mt_seed() has not been called, */
+            mt_seed(st, 5489UL); /* a default initial seed is used */
 
         for (kk=0;kk<N-M;kk++) {
             y = (mt[kk]&UPPER_MASK)|(mt[kk+1]&LOWER_MASK);
@@ -122,10 +133,10 @@ unsigned long genrand_int32(void)
         y = (mt[N-1]&UPPER_MASK)|(mt[0]&LOWER_MASK);
         mt[N-1] = mt[M-1] ^ (y >> 1) ^ mag01[y & 0x1UL];
 
-        mti = 0;
+        st->mti = 0;
     }
   
-    y = mt[mti++];
+    y = mt[st->mti++];
 
     /* Tempering */
     y ^= (y >> 11);
@@ -133,7 +144,23 @@ unsigned long genrand_int32(void)
     y ^= (y << 15) & 0xefc60000UL;
     y ^= (y >> 18);
 
-    return y;
+    return (uint32_t)y;
+}
+
+/* The original interface, on the default stream */
+void init_genrand(unsigned long s)
+{
+    rng_init(&g_rng, s);
+}
+
+void init_by_array(unsigned long init_key[], int key_length)
+{
+    rng_init_by_array(&g_rng, RNG_DEFAULT, init_key, key_length);
+}
+
+unsigned long genrand_int32(void)
+{
+    return rng_u32(&g_rng);
 }
 
 /* generates a random number on [0,0x7fffffff]-interval */
@@ -175,40 +202,31 @@ double genrand_res53(void)
  * Functions below added by Zach Wilder, 2022, with the same conditions as
  * above.
  *
+ * uint32_t mt_rand_below(uint32_t n);
  * int mt_rand(int min, int max); 
  * bool mt_bool(void); 
  * bool mt_chance(int chance);
  *
+ * These all draw from the default stream now, the real work is done by the
+ * rng_* functions in rng.c which can be handed any stream.
  */
+uint32_t mt_rand_below(uint32_t n) {
+    return rng_bounded(&g_rng, n);
+}
+
 int mt_rand_lim(int limit) {
-    /* So, the random number functions below with the % operator will introduce
-     * skew. Like trying to split ten candies with 3 kids - and not being able
-     * to cut anything into smaller pieces. A single piece will be left over...
-     * This takes the candy, divides it by 3, and if the result is greater than
-     * 3 puts it back into the bucket. */
-    int divisor = RAND_MAX/(limit + 1);
-    int retval;
-    do {
-        retval = genrand_int32() / divisor;
-    } while (retval > limit);
-
-    return retval;
+    // 0 to limit (inclusive)
+    return (int)rng_bounded(&g_rng, limit + 1);
 }
 
 int mt_rand(int min, int max) {
-    return (mt_rand_lim(max - min) + min);
+    return rng_range(&g_rng, min, max);
 }
 
 bool mt_bool() {
-    int result = mt_rand(1,10);
-    return (result <= 5);
+    return rng_bool(&g_rng);
 }
 
 bool mt_chance(int chance) {
-    /* Idea: I want a 1/3 chance of something happening, so I call
-     * mt_chance(33). It gets a random number between 1 and 100, and then
-     * returns true if the random number is less than the 33. */
-    int result = mt_rand(1,100);
-    return(result <= chance);
+    return rng_chance(&g_rng, chance);
 }
-
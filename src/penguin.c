@@ -28,15 +28,26 @@ bool penguin_init(void) {
      */
     bool ret_to_main = false;
     int i = 0, j = 0;
+    unsigned long allocs = 0;
 
-    if(g_penguin) penguin_cleanup();
-    // Allocate memory for decks/buttons
-    g_penguin = create_solitaire(PN_NUM_DECKS);
+    // Anything carved out for this deal that didn't fit in the arena
+    allocs = arena_heap_allocs();
 
-    // Register events/update/draw functions
-    g_penguin->events = &penguin_events;
-    g_penguin->update = &penguin_update;
-    g_penguin->draw = &penguin_draw;
+    // A restart reuses the game that's already there, it's just emptied out
+    if(g_penguin) {
+        reset_solitaire(g_penguin);
+    } else {
+        // Allocate memory for decks/buttons
+        g_penguin = create_solitaire(PN_NUM_DECKS);
+    }
+
+    // Register events/update/draw/layout with the game loop
+    g_penguin->loop->name = "penguin";
+    g_penguin->loop->events = &penguin_events;
+    g_penguin->loop->update = &penguin_update;
+    g_penguin->loop->draw = &penguin_draw;
+    g_penguin->loop->click = &penguin_click;
+    g_penguin->layout = &penguin_layout;
 
     // Put the buttons in the right spot
     j = 0;
@@ -65,12 +76,15 @@ bool penguin_init(void) {
         j++;
     }
     
-    // Put 52 cards in the stock, and shuffle it
-    fill_deck(g_penguin->decks[PN_STOCK]);
-    shuffle_deck(g_penguin->decks[PN_STOCK]);
+    // Put the 52 cards in the shoe in the stock, and shuffle it
+    fill_deck_from_shoe(g_penguin->decks[PN_STOCK], g_penguin->shoe);
+    g_penguin->deal = take_next_deal();
+    shuffle_deal(g_penguin->decks[PN_STOCK], &g_penguin->rng, g_penguin->deal);
 
     // Deal the cards, draw the cards, enter the loop
     penguin_deal();
+    g_penguin->loop->stats.deals += 1;
+    g_penguin->loop->stats.deal_allocs = arena_heap_allocs() - allocs;
     penguin_update();
     penguin_draw();
     penguin_loop();
@@ -104,7 +118,7 @@ void penguin_deal(void) {
 
     // The first card in PN_TAB_A is the "beak", we need to find the matching
     // rank cards in the deck and move them to the appropriate foundation
-    beak = g_penguin->decks[PN_TAB_A]->cards; 
+    beak = get_first_card(g_penguin->decks[PN_TAB_A]);
     rflag = get_rank_flag(beak->flags);
     card = search_deck(stock, rflag);
     while(card) {
@@ -149,25 +163,29 @@ void penguin_deal(void) {
 
 void penguin_loop(void) {
     // Main loop
-    solitaire_loop(g_penguin);
+    game_loop_run(g_penguin->loop);
 
     // Score check here... If score is new high score, save it
     if(g_penguin->score > g_settings->penguin_hs) {
         g_settings->penguin_hs = g_penguin->score;
+        g_settings->penguin_hs_deal = g_penguin->deal;
     }
     if(g_penguin->score) {
         g_settings->penguin_last = g_penguin->score;
         add_new_score_chrono(g_settings->penguin_scores,
-                g_penguin->score);
+                g_penguin->score, g_penguin->deal);
     }
     save_settings();
 }
 
-void penguin_events(void) {
+bool penguin_click(KeyEvent *key) {
+    return solitaire_click(g_penguin, key);
+}
+
+void penguin_events(KeyEvent *key) {
     bool redraw = true;
-    char ch = kb_get_char();
     int btn_id = -1; 
-    switch(ch) {
+    switch(key->key) {
         case 'A':
         case 'a': btn_id = PN_TAB_A; break;
         case 'B':
@@ -204,7 +222,11 @@ void penguin_events(void) {
         case 't':
                   g_penguin->flags ^= GFL_TARGET;
                   break;
-        case 27:
+        case 'U':
+        case 'u': solitaire_undo(g_penguin); break;
+        case 'R':
+        case 'r': solitaire_redo(g_penguin); break;
+        case KEY_ESC:
         case 'q': solitaire_pause(g_penguin); break;
         default: redraw = false; break;
     }
@@ -107,11 +107,10 @@ void penguin_draw(void) {
             x = (6*i) + xo;
             // Get the current deck
             deck = g_penguin->decks[PN_TAB_A + i];
-            if(deck->cards) {
+            if(deck->count) {
                 // Print the tops of all cards, except the last    
-                j = 0;
-                cards = deck->cards;
-                while(cards->next) {
+                for(j = 0; j < deck->count - 1; j++) {
+                    cards = deck->cards[j];
                     y = j + yo;
                     // Idea: what if we set a toggle to a keypress 
                     // to "highlight" the "next" card up from the 
@@ -121,10 +120,9 @@ void penguin_draw(void) {
                     } else {
                         pt_card_top(x,y,cards);
                     }
-                    j++;
-                    cards = cards->next;
                 }
                 // Print the last card
+                cards = deck->cards[j];
                 y = j + yo;
                 if(penguin_find_next_card(cards)) {
                     pt_card_blink(x,y,cards);
@@ -146,8 +144,8 @@ void penguin_draw(void) {
         x = 44 + (5*i) + xo;
         y = 1 + yo;
         deck = g_penguin->decks[PN_CELL_A + i];
-        if(deck->cards) {
-            cards = deck->cards;
+        if(deck->count) {
+            cards = deck->cards[0];
             if(penguin_find_next_card(cards)) {
                 pt_card_blink(x,y,cards);
             } else {
@@ -164,8 +162,8 @@ void penguin_draw(void) {
         deck = g_penguin->decks[PN_FND_H + i];
         x = 59 + (5*i) + xo;
         y = 7+yo;
-        if(deck->cards) {
-            base = get_rank(deck->cards->flags);
+        if(deck->count) {
+            base = get_rank(deck->cards[0]->flags);
             cards = get_last_card(deck);
             if(cards) {
                 pt_card(x,y,cards);
@@ -183,7 +181,7 @@ void penguin_draw(void) {
     }
 
     // Draw message
-    if(g_penguin->msg) {
+    if(g_penguin->msg[0]) {
         scr_pt_clr(xo, 21+yo, WHITE, BLACK, "%s",
                 g_penguin->msg);
     }
@@ -194,12 +192,14 @@ void penguin_draw(void) {
     // Draw status
     if(base == 1) {
         scr_pt_clr(xo,23+yo,BRIGHT_BLACK,BLACK,
-                "Base: A. High score: %d. Last score: %d.",
-                g_settings->penguin_hs, g_settings->penguin_last);
+                "Base: A. High score: %d. Last score: %d. Deal #%llu.",
+                g_settings->penguin_hs, g_settings->penguin_last,
+                (unsigned long long)g_penguin->deal);
     } else if(base < 11) {
         scr_pt_clr(xo,23+yo,BRIGHT_BLACK,BLACK,
-                "Base: %d. High score: %d. Last score: %d.", 
-                base, g_settings->penguin_hs, g_settings->penguin_last);
+                "Base: %d. High score: %d. Last score: %d. Deal #%llu.", 
+                base, g_settings->penguin_hs, g_settings->penguin_last,
+                (unsigned long long)g_penguin->deal);
     } else {
         switch(base) {
             case 11: ch = 'J'; break;
@@ -208,38 +208,55 @@ void penguin_draw(void) {
             default: ch = '?'; break;
         }
         scr_pt_clr(xo,23+yo,BRIGHT_BLACK,BLACK,
-                "Base: %c. High score: %d. Last score: %d.",
-                ch, g_settings->penguin_hs, g_settings->penguin_last);
+                "Base: %c. High score: %d. Last score: %d. Deal #%llu.",
+                ch, g_settings->penguin_hs, g_settings->penguin_last,
+                (unsigned long long)g_penguin->deal);
     }
     g_penguin->flags &= ~GFL_DRAW;
 }
 
+void penguin_layout(HitGrid *hits) {
+    /* Mouse targets, same spots as penguin_draw() above. The tableau buttons
+     * sit underneath the cards, so they move as the tableaus grow/shrink. */
+    int i = 0, h = 0;
+    Button **btns = g_penguin->btns;
+    for(i = 0; i < 7; i++) {
+        h = g_penguin->decks[PN_TAB_A + i]->count + 3;
+        if(h < 4) h = 4;
+        hitgrid_add(hits, 6*i, 0, 4, h, btns[PN_TAB_A + i]->ch);
+        hitgrid_add_button(hits, btns[PN_TAB_A + i], btns[PN_TAB_A + i]->x,
+                btns[PN_TAB_A + i]->y + h);
+    }
+    for(i = 0; i < 7; i++) {
+        hitgrid_add(hits, 44 + (5*i), 1, 4, 4, btns[PN_CELL_A + i]->ch);
+        hitgrid_add_button(hits, btns[PN_CELL_A + i], btns[PN_CELL_A + i]->x,
+                btns[PN_CELL_A + i]->y);
+    }
+    for(i = 0; i < 4; i++) {
+        hitgrid_add(hits, 59 + (5*i), 7, 4, 4, btns[PN_FND_H + i]->ch);
+        hitgrid_add_button(hits, btns[PN_FND_H + i], btns[PN_FND_H + i]->x,
+                btns[PN_FND_H + i]->y);
+    }
+}
+
 bool penguin_find_next_card(Card *card) {
     /* Take the rank and suite of card and see if it is exactly 1 higher than
      * the rank of the matching suite in the foundation
      */
     bool success = false;
-    Deck *fnd = NULL;
     Card *fnd_top_card = NULL;
     int i = 0;
-    int card_rank = 0, fnd_rank = 0;
 
     if(!card) return success;
     if(!(check_flag(g_penguin->flags, GFL_TARGET))) return success;
 
-    card_rank = get_rank(card->flags);
     for(i = 0; i < 4; i++) {
-        fnd = g_penguin->decks[PN_FND_H + i];
-        fnd_top_card = get_last_card(fnd);
+        fnd_top_card = get_last_card(g_penguin->decks[PN_FND_H + i]);
         if(!fnd_top_card) continue;
-        if(card_same_suite(fnd_top_card->flags, card->flags)) {
-            // We want the rank exactly one higher than the fnd rank
-            fnd_rank = get_rank(fnd_top_card->flags) + 1;
-            if(fnd_rank > 13) fnd_rank = 1; // Next higher than K is A
-            if(fnd_rank == card_rank) {
-                success = true;
-                break;
-            }
+        // Same suite, and exactly one higher (next higher than K is A)
+        if(card_follows_wrap(card->flags, fnd_top_card->flags)) {
+            success = true;
+            break;
         }
     }
     return success;
@@ -19,25 +19,31 @@
 */
 #include <cards.h>
 
+void penguin_another_game(char answer, void *data) {
+    // Answer to the prompt when the game is won
+    if(answer == 'Y') {
+        g_penguin->flags |= GFL_RESTART;
+    } else {
+        g_penguin->flags |= GFL_QTOMAIN;
+        g_penguin->flags &= ~GFL_RUNNING;
+    }
+}
+
 void penguin_update(void) {
     int i = 0, count = 0;
+    CardSet found = 0;
     int id_a = 0, id_b = 0;
 
     // Check win condition
     if(check_flag(g_penguin->flags, GFL_WIN)) {
         // None of the rest of update needs to run
-        // Maybe put a prompt here to start a new game?
-        g_penguin->flags |= GFL_DRAW;
-        g_penguin->draw();
-        if(solitaire_prompt("Another game? (y/n): ") == 'Y') {
-            g_penguin->flags |= GFL_RESTART;
-        } else {
-            g_penguin->flags |= GFL_QTOMAIN;
-            g_penguin->flags &= ~GFL_RUNNING;
-        }
+        solitaire_prompt(g_penguin, &penguin_another_game, "Another game? (y/n): ");
         return;
     }
 
+    // Anything this key does to the cards is one move, for undo
+    journal_step(&g_penguin->journal);
+
     // Count the selected buttons
     count = 0;
     for(i = 0; i < PN_NUM_DECKS; i++) {
@@ -55,7 +61,7 @@ void penguin_update(void) {
     } else if (1 == count) {
         // If 1, set "from" reference IF there is a card in the "from" deck
         g_penguin->fromref = g_penguin->decks[id_a]; 
-        if(!g_penguin->fromref->cards) {
+        if(!g_penguin->fromref->count) {
             // No cards in "from", NULL reference deactivate button
             g_penguin->btns[id_a]->selected = false;
             g_penguin->fromref = NULL;
@@ -78,8 +84,9 @@ void penguin_update(void) {
             // Moving to cell
             // Can only have one card in each cell
             // Is cell empty?
-            if(!g_penguin->toref->cards) {
-                move_last_card_to_deck(g_penguin->fromref,g_penguin->toref);
+            if(!g_penguin->toref->count) {
+                solitaire_move(g_penguin, g_penguin->fromref,
+                        g_penguin->fromref->count - 1, g_penguin->toref, false);
                 solitaire_msg(g_penguin, " ");
             } else if((g_penguin->fromref->id >= PN_CELL_A) &&
                     (g_penguin->fromref->id <= PN_CELL_G)) {
@@ -110,11 +117,11 @@ void penguin_update(void) {
 
     // Check win condition
     if(!check_flag(g_penguin->flags, GFL_WIN)) {
-        count = 0;
+        found = 0;
         for(i = PN_FND_H; i <= PN_FND_S; i++) {
-            count += count_cards(g_penguin->decks[i]->cards); 
+            found |= g_penguin->decks[i]->set;
         }
-        if(count == 52) {
+        if(found == CARDSET_ALL) {
             // all 52 cards are on the foundations
             g_penguin->flags |= GFL_WIN;
             g_settings->penguin_wins += 1;
@@ -125,7 +132,7 @@ void penguin_update(void) {
             }
             g_penguin->fromref = NULL;
             g_penguin->toref = NULL;
-            g_penguin->score += 50;
+            solitaire_score(g_penguin, 50);
         }
     }
 }
@@ -134,17 +141,13 @@ void penguin_foundation_move(void) {
     bool valid_move = false;
     Card *fromcard = get_last_card(g_penguin->fromref);
     Card *tocard = get_last_card(g_penguin->toref);
-    Card *seqcard = NULL;
+    Deck *from = g_penguin->fromref;
     int base = 0, i = 0, seqcount = 0;
     //Moving card from somwhere to a foundation
     //Is the foundation empty? Check to see if card is the beak.
-    if(!g_penguin->toref->cards) {
+    if(!g_penguin->toref->count) {
         // Find base
-        for(i = PN_FND_H; i <= PN_FND_S; i++) {
-            if(!g_penguin->decks[i]->cards) continue;
-            base = get_rank(g_penguin->decks[i]->cards->flags);
-            break;
-        }
+        base = penguin_find_base();
         // Check fromref
         if(get_rank(fromcard->flags) == base) {
             valid_move = true;
@@ -157,21 +160,20 @@ void penguin_foundation_move(void) {
 
     if(valid_move) {
         // Find highest card in sequence above the valid move
-        seqcard = fromcard;
-        while(seqcard->prev) {
-            if(!penguin_valid_move(seqcard->prev->flags, seqcard->flags)) {
+        for(i = from->count - 1; i > 0; i--) {
+            if(!penguin_valid_move(from->cards[i-1]->flags,
+                        from->cards[i]->flags)) {
                 break;
             }
-            seqcard = seqcard->prev;
             seqcount += 1; // Keep track of how many in sequence for points
         }
-        // Move one to seqcount cards "from" to "to"
-        for(i = seqcount; i >= 0; i--) {
-            move_last_card_to_deck(g_penguin->fromref,g_penguin->toref);
-        }
+        // Move one to seqcount cards "from" to "to" - the sequence runs down
+        // the tableau, so it goes up onto the foundation backwards
+        solitaire_move(g_penguin, from, from->count - 1 - seqcount,
+                g_penguin->toref, true);
 
         // Give points, 15 for each card, moved to the foundation
-        g_penguin->score += 15 + (15*seqcount);
+        solitaire_score(g_penguin, 15 + (15*seqcount));
         solitaire_msg(g_penguin, "Moved %d cards for %d points!", seqcount+1, 
                 (15 + (15*seqcount)));
          
@@ -185,7 +187,9 @@ void penguin_tableau_move(void) {
     Card *fromcard = get_last_card(g_penguin->fromref);
     Card *tocard = get_last_card(g_penguin->toref);
     Card *seqcard = NULL;
+    Deck *from = g_penguin->fromref;
     int highcard = penguin_find_high_card();
+    int i = 0;
     if(!tocard) {
         //If tocard is NULL, is fromcard one lower than the base card?
         if(get_rank(fromcard->flags) == highcard) {
@@ -199,9 +203,10 @@ void penguin_tableau_move(void) {
     if(valid_move) {
         if((g_penguin->fromref->id >= PN_TAB_A) &&
                 (g_penguin->fromref->id <= PN_TAB_G)) {
-            g_penguin->score += 5;
+            solitaire_score(g_penguin, 5);
         }
-        move_last_card_to_deck(g_penguin->fromref,g_penguin->toref);
+        solitaire_move(g_penguin, g_penguin->fromref,
+                g_penguin->fromref->count - 1, g_penguin->toref, false);
         solitaire_msg(g_penguin, " ");
     } else {
         solitaire_msg(g_penguin, "Invalid move, try something else.");
@@ -210,20 +215,20 @@ void penguin_tableau_move(void) {
     if(!valid_move) {
         // Check to see if last card is in sequence, if it is compare first card of
         // sequence to tocard. 
-        seqcard = fromcard;
-        while(seqcard->prev) {
-            //if seqcard->prev is one higher and same suit then...
+        for(i = from->count - 1; i > 0; i--) {
+            //if the card before is one higher and same suit then...
             //continue, if not break
-            if(!penguin_valid_move(seqcard->prev->flags, seqcard->flags)) {
+            if(!penguin_valid_move(from->cards[i-1]->flags,
+                        from->cards[i]->flags)) {
                 break;
             }
-            seqcard = seqcard->prev; 
         }
+        seqcard = from->cards[i];
         // if seqcard != from card then we want to test seqcard and tocard
         if(!tocard) {
             //attempting to move a sequence to a blank spot
             if(get_rank(seqcard->flags) == highcard) {
-                move_chain_card(seqcard, g_penguin->fromref, g_penguin->toref);
+                solitaire_move(g_penguin, from, i, g_penguin->toref, false);
                 solitaire_msg(g_penguin, " ");
             } else {
                 solitaire_msg(g_penguin, "Invalid move, high card is %d", highcard);
@@ -231,9 +236,9 @@ void penguin_tableau_move(void) {
         } else if(penguin_valid_move(tocard->flags,seqcard->flags)) {
             if((g_penguin->fromref->id >= PN_TAB_A) &&
                     (g_penguin->fromref->id <= PN_TAB_G)) {
-                g_penguin->score += 5;
+                solitaire_score(g_penguin, 5);
             }
-            move_chain_card(seqcard, g_penguin->fromref, g_penguin->toref);
+            solitaire_move(g_penguin, from, i, g_penguin->toref, false);
             solitaire_msg(g_penguin, " ");
         }
     }
@@ -243,12 +248,11 @@ void penguin_cell_swap(void) {
     if(!g_penguin->fromref || !g_penguin->toref) return;
     Deck *from = g_penguin->fromref;
     Deck *to = g_penguin->toref;
-    Card *tmp = from->cards;
+    if(!from->count || !to->count) return;
     if((from->id >= PN_CELL_A) && (from->id <= PN_CELL_G) &&
            (to->id >= PN_CELL_A) && (to->id <= PN_CELL_G)) {
         // Swap the cards
-        from->cards = to->cards;
-        to->cards = tmp;
+        solitaire_swap(g_penguin, from, 0, to, 0);
         solitaire_msg(g_penguin, " ");
     } 
 }
@@ -266,17 +270,14 @@ bool penguin_asc_sequence(int a, int b) {
 }
 
 bool penguin_valid_move(int a, int b) {
-    if(card_same_suite(a,b) && penguin_asc_sequence(a,b)) {
-        return true;
-    }
-    return false;
+    return card_follows_wrap(a,b);
 }
 
 int penguin_find_base(void) {
     int i = 0;
     for(i = PN_FND_H; i <= PN_FND_S; i++) {
-        if(!g_penguin->decks[i]->cards) continue;
-        return get_rank(g_penguin->decks[i]->cards->flags);
+        if(!g_penguin->decks[i]->count) continue;
+        return get_rank(g_penguin->decks[i]->cards[0]->flags);
     }
     return 0; // Shouldn't reach this point
 }
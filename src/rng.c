@@ -0,0 +1,311 @@
+/*
+* Cards
+* Copyright (C) Zach Wilder 2024
+* 
+* This file is a part of Cards
+*
+* Cards is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+* 
+* Cards is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+* 
+* You should have received a copy of the GNU General Public License
+* along with Cards.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#include <cards.h>
+
+// Seeded in main(), but until then it's the same as rng_init(&g_rng, 5489)
+// (the seed MT19937 falls back on too) so it's never all zeros
+Rng g_rng = { .kind = RNG_XOSHIRO, .xs = { 0x47ee8bf6a1aaf709ULL,
+    0xc85ce266f96d1180ULL, 0x0846a1d3e2cce4eeULL, 0x8184716d603ffc25ULL } };
+
+/*****
+ * xoshiro256** by David Blackman and Sebastiano Vigna (public domain), see
+ * https://prng.di.unimi.it/. Seeded with splitmix64, like they recommend, so
+ * even seeds like 0 and 1 give good, very different states.
+ *****/
+static uint64_t splitmix64(uint64_t *x) {
+    uint64_t z = (*x += 0x9e3779b97f4a7c15ULL);
+    z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+    return z ^ (z >> 31);
+}
+
+static inline uint64_t rotl(uint64_t x, int k) {
+    return (x << k) | (x >> (64 - k));
+}
+
+static inline uint64_t xoshiro_next(uint64_t *s) {
+    uint64_t result = rotl(s[1] * 5, 7) * 9;
+    uint64_t t = s[1] << 17;
+    s[2] ^= s[0];
+    s[3] ^= s[1];
+    s[1] ^= s[2];
+    s[0] ^= s[3];
+    s[2] ^= t;
+    s[3] = rotl(s[3], 45);
+    return result;
+}
+
+static inline void xoshiro_next_lanes(RngLanes *s, RngLanes *out) {
+    /* Same as xoshiro_next(), on every lane at once. Vectors go in and out
+     * through pointers, passing 32 byte vectors by value changes the calling
+     * convention depending on whether AVX is turned on. */
+    RngLanes t = s[1] * 5;
+    *out = ((t << 7) | (t >> 57)) * 9;
+    t = s[1] << 17;
+    s[2] ^= s[0];
+    s[3] ^= s[1];
+    s[1] ^= s[2];
+    s[0] ^= s[3];
+    s[2] ^= t;
+    s[3] = (s[3] << 45) | (s[3] >> 19);
+}
+
+/*****
+ * Streams
+ *****/
+void rng_init(Rng *rng, unsigned long seed) {
+    rng_init_kind(rng, RNG_DEFAULT, seed);
+}
+
+void rng_init_kind(Rng *rng, RngKind kind, uint64_t seed) {
+    uint64_t x = seed;
+    int i = 0;
+    rng->kind = kind;
+    if(kind == RNG_MT19937) {
+        mt_seed(&rng->mt, seed);
+        return;
+    }
+    for(i = 0; i < 4; i++) {
+        rng->xs[i] = splitmix64(&x);
+    }
+}
+
+void rng_init_entropy(Rng *rng) {
+    /* Seeding with time(NULL) gives two games started in the same second the
+     * same cards. Ask the OS for some random bytes, and mix in the time down
+     * to the nanosecond and the process id in case that doesn't work. */
+    unsigned long key[4] = {0, 0, 0, 0};
+    struct timespec ts;
+    FILE *f = fopen("/dev/urandom", "rb");
+    if(f) {
+        if(fread(key, sizeof(unsigned long), 1, f) != 1) key[0] = 0;
+        fclose(f);
+    }
+    clock_gettime(CLOCK_REALTIME, &ts);
+    key[1] = ts.tv_sec;
+    key[2] = ts.tv_nsec;
+    key[3] = getpid();
+    rng_init_by_array(rng, RNG_DEFAULT, key, 4);
+}
+
+void rng_init_by_array(Rng *rng, RngKind kind, unsigned long key[], int len) {
+    /* MT19937 has its own way of doing this. For xoshiro, run the whole key
+     * through splitmix64 so every part of it changes the state. */
+    uint64_t x = 0;
+    int i = 0;
+    if(kind == RNG_MT19937) {
+        rng->kind = kind;
+        mt_seed_by_array(&rng->mt, key, len);
+        return;
+    }
+    for(i = 0; i < len; i++) {
+        x ^= key[i];
+        x = splitmix64(&x);
+    }
+    rng_init_kind(rng, RNG_XOSHIRO, x);
+}
+
+uint64_t rng_u64(Rng *rng) {
+    // Two draws for MT19937, the first is the high half (C doesn't promise
+    // which call in "a() << 32 | a()" happens first, so they're split up)
+    uint64_t hi = 0, lo = 0;
+    if(rng->kind == RNG_MT19937) {
+        hi = mt_next(&rng->mt);
+        lo = mt_next(&rng->mt);
+        return (hi << 32) | lo;
+    }
+    return xoshiro_next(rng->xs);
+}
+
+uint32_t rng_u32(Rng *rng) {
+    // The top half of xoshiro's output is the better half
+    if(rng->kind == RNG_MT19937) return mt_next(&rng->mt);
+    return (uint32_t)(xoshiro_next(rng->xs) >> 32);
+}
+
+uint32_t rng_bounded(Rng *rng, uint32_t n) {
+    /* So, just taking the random number % n will introduce skew. Like trying
+     * to split ten candies with 3 kids - and not being able to cut anything
+     * into smaller pieces. A single piece will be left over...
+     * Lemire's way around it: multiply the 32 bit random number by n, and the
+     * top 32 bits of the 64 bit result are somewhere from 0 to n - 1. The
+     * bottom 32 bits say where in that slot it landed, and only the first
+     * (2^32 % n) spots of a slot are the leftover candy that makes things
+     * uneven - draw again if it landed there. The % to work out how much is
+     * leftover only happens when it's even possible to be in the leftovers,
+     * which for a deck of cards is almost never. */
+    uint64_t m = 0;
+    uint32_t low = 0, leftover = 0;
+    if(n < 2) return 0;
+    m = (uint64_t)rng_u32(rng) * n;
+    low = (uint32_t)m;
+    if(low < n) {
+        leftover = (uint32_t)(-n) % n; // 2^32 % n, without needing 64 bits
+        while(low < leftover) {
+            m = (uint64_t)rng_u32(rng) * n;
+            low = (uint32_t)m;
+        }
+    }
+    return (uint32_t)(m >> 32);
+}
+
+/*****
+ * Bulk
+ *****/
+void rng_bulk_init(RngBulk *bulk, unsigned long seed) {
+    Rng rng;
+    rng_init_kind(&rng, RNG_XOSHIRO, seed);
+    rng_bulk_init_rng(bulk, &rng);
+}
+
+void rng_bulk_init_rng(RngBulk *bulk, Rng *rng) {
+    /* Lane 0 starts where rng is, every lane after that 2^128 further on,
+     * and then rng itself is long jumped 2^192 ahead - past all of the lanes,
+     * so nothing it hands out after this is repeated by one of them. An
+     * MT19937 rng just gets a xoshiro seed drawn out of it. */
+    Rng lane;
+    int i = 0, j = 0;
+    if(rng->kind == RNG_XOSHIRO) {
+        lane = *rng;
+        rng_long_jump(rng);
+    } else {
+        rng_init_kind(&lane, RNG_XOSHIRO, rng_u64(rng));
+    }
+    for(i = 0; i < RNG_BULK_LANES; i++) {
+        for(j = 0; j < 4; j++) {
+            bulk->s[j][i] = lane.xs[j];
+        }
+        rng_jump(&lane);
+    }
+    bulk->pos = RNG_BULK_SZ;
+}
+
+void rng_fill_u32(RngBulk *bulk, uint32_t *out, size_t n) {
+    /* Each step of the lanes is RNG_BULK_LANES 64 bit numbers, or twice that
+     * many 32 bit ones. A partial step at the end throws the rest away. */
+    RngLanes r;
+    size_t i = 0, step = sizeof(RngLanes) / sizeof(uint32_t);
+    for(i = 0; i + step <= n; i += step) {
+        xoshiro_next_lanes(bulk->s, &r);
+        memcpy(out + i, &r, sizeof(RngLanes));
+    }
+    if(i < n) {
+        xoshiro_next_lanes(bulk->s, &r);
+        memcpy(out + i, &r, (n - i) * sizeof(uint32_t));
+    }
+}
+
+uint32_t rng_bulk_u32(RngBulk *bulk) {
+    if(bulk->pos >= RNG_BULK_SZ) {
+        rng_fill_u32(bulk, bulk->buf, RNG_BULK_SZ);
+        bulk->pos = 0;
+    }
+    return bulk->buf[bulk->pos++];
+}
+
+uint32_t rng_bulk_bounded(RngBulk *bulk, uint32_t n) {
+    // Same as rng_bounded(), see there for how it works
+    uint64_t m = 0;
+    uint32_t low = 0, leftover = 0;
+    if(n < 2) return 0;
+    m = (uint64_t)rng_bulk_u32(bulk) * n;
+    low = (uint32_t)m;
+    if(low < n) {
+        leftover = (uint32_t)(-n) % n;
+        while(low < leftover) {
+            m = (uint64_t)rng_bulk_u32(bulk) * n;
+            low = (uint32_t)m;
+        }
+    }
+    return (uint32_t)(m >> 32);
+}
+
+/*****
+ * Jumping and splitting
+ *****/
+static void xoshiro_jump(uint64_t *s, const uint64_t *jump) {
+    /* Jumping is the same as calling xoshiro_next() a huge number of times -
+     * add up (xor) the states that the jump polynomial picks out while
+     * stepping through 256 of them. From the xoshiro256** reference code. */
+    uint64_t t[4] = {0, 0, 0, 0};
+    int i = 0, b = 0;
+    for(i = 0; i < 4; i++) {
+        for(b = 0; b < 64; b++) {
+            if(jump[i] & ((uint64_t)1 << b)) {
+                t[0] ^= s[0];
+                t[1] ^= s[1];
+                t[2] ^= s[2];
+                t[3] ^= s[3];
+            }
+            xoshiro_next(s);
+        }
+    }
+    memcpy(s, t, sizeof(t));
+}
+
+void rng_jump(Rng *rng) {
+    static const uint64_t jump[4] = { 0x180ec6d33cfd0abaULL,
+        0xd5a61266f0c9392cULL, 0xa9582618e03fc9aaULL, 0x39abdc4529b1661cULL };
+    if(rng->kind == RNG_XOSHIRO) xoshiro_jump(rng->xs, jump);
+}
+
+void rng_long_jump(Rng *rng) {
+    static const uint64_t jump[4] = { 0x76e15d3efefdcbbfULL,
+        0xc5004e441c522fb3ULL, 0x77710069854ee241ULL, 0x39109bb02acbe635ULL };
+    if(rng->kind == RNG_XOSHIRO) xoshiro_jump(rng->xs, jump);
+}
+
+void rng_split(Rng *child, Rng *parent, uint32_t index) {
+    /* See rng.h. The parent isn't changed, so splitting it doesn't use up
+     * any of its numbers. */
+    unsigned long key[3] = {0, 0, 0};
+    uint32_t i = 0;
+    int j = 0;
+    if(parent->kind == RNG_MT19937) {
+        // Boil the parent's state down to a key, and add the index
+        for(j = 0; j < MT_N; j++) {
+            key[j % 2] = (key[j % 2] * 31) ^ parent->mt.mt[j];
+        }
+        key[1] ^= parent->mt.mti;
+        key[2] = index;
+        child->kind = RNG_MT19937;
+        mt_seed_by_array(&child->mt, key, 3);
+        return;
+    }
+    *child = *parent;
+    for(i = 0; i <= index; i++) {
+        rng_long_jump(child);
+    }
+}
+
+int rng_range(Rng *rng, int min, int max) {
+    return (int)rng_bounded(rng, max - min + 1) + min;
+}
+
+bool rng_bool(Rng *rng) {
+    return (rng_range(rng, 1, 10) <= 5);
+}
+
+bool rng_chance(Rng *rng, int chance) {
+    /* Idea: I want a 1/3 chance of something happening, so I call
+     * rng_chance(rng, 33). It gets a random number between 1 and 100, and
+     * then returns true if the random number is less than the 33. */
+    return (rng_range(rng, 1, 100) <= chance);
+}
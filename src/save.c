@@ -74,6 +74,18 @@ void save_settings(void) {
                         g_settings->penguin_scores[i].datelength,f);
             }
         }
+
+        // Deal numbers for the scores came later, so they go on the end
+        for(i = 0; i < 5; i++) {
+            if(!g_settings->klondike_scores) break;
+            fwrite(&(g_settings->klondike_scores[i].deal),sizeof(uint64_t),1,f);
+        }
+        for(i = 0; i < 5; i++) {
+            if(!g_settings->penguin_scores) break;
+            fwrite(&(g_settings->penguin_scores[i].deal),sizeof(uint64_t),1,f);
+        }
+        fwrite(&(g_settings->klondike_hs_deal),sizeof(uint64_t),1,f);
+        fwrite(&(g_settings->penguin_hs_deal),sizeof(uint64_t),1,f);
         
     }
 
@@ -151,6 +163,27 @@ bool load_settings(void) {
             bytesread += fread(g_settings->penguin_scores[i].date, sizeof(char),
                     g_settings->penguin_scores[i].datelength,f);
         }
+
+        // Files from before deal numbers just don't have these, so the deals
+        // stay 0 (unknown)
+        for(i = 0; i < 5; i++) {
+            g_settings->klondike_scores[i].deal = 0;
+            g_settings->penguin_scores[i].deal = 0;
+        }
+        g_settings->klondike_hs_deal = 0;
+        g_settings->penguin_hs_deal = 0;
+        for(i = 0; i < 5; i++) {
+            bytesread += fread(&(g_settings->klondike_scores[i].deal),
+                    sizeof(uint64_t), 1,f);
+        }
+        for(i = 0; i < 5; i++) {
+            bytesread += fread(&(g_settings->penguin_scores[i].deal),
+                    sizeof(uint64_t), 1,f);
+        }
+        bytesread += fread(&(g_settings->klondike_hs_deal), sizeof(uint64_t),
+                1,f);
+        bytesread += fread(&(g_settings->penguin_hs_deal), sizeof(uint64_t),
+                1,f);
         
         success = true;
         fclose(f);
@@ -168,6 +201,8 @@ bool load_settings(void) {
         g_settings->penguin_hs = 0;
         g_settings->penguin_last = 0;
         g_settings->penguin_wins = 0;
+        g_settings->klondike_hs_deal = 0;
+        g_settings->penguin_hs_deal = 0;
         g_settings->klondike_scores = create_highscores();
         g_settings->penguin_scores = create_highscores();
     }
@@ -54,6 +54,8 @@ void init_settings(void) {
     g_settings->penguin_hs = 0;
     g_settings->penguin_last = 0;
     g_settings->penguin_wins = 0;
+    g_settings->klondike_hs_deal = 0;
+    g_settings->penguin_hs_deal = 0;
     /*
      * The high scores aren't created/initialized here because they are checked
      * for during the data file loading in save.c. If the cards.bin file doesn't
@@ -0,0 +1,264 @@
+/*
+* Cards
+* Copyright (C) Zach Wilder 2024
+* 
+* This file is a part of Cards
+*
+* Cards is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+* 
+* Cards is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+* 
+* You should have received a copy of the GNU General Public License
+* along with Cards.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#include <cards.h>
+
+/*****
+ * Shuffle tests, run with "Cards --shuffle-test [shuffles] [seed]". Shuffles a
+ * sorted deck over and over and checks that the result looks random:
+ *  - Where each card ends up: every card should land in every spot 1/52 of
+ *    the time (chi-square over the 52x52 card/position table)
+ *  - Which card follows which: every ordered pair of different cards should
+ *    be next to each other equally often (chi-square over 52x51 pairs)
+ *  - The top card: every card should be on top 1/52 of the time
+ * and then times how many shuffles a second it can do. A p-value under
+ * SHUF_FAIL_P fails the test (with a million shuffles that's not going to
+ * happen by bad luck), and the exit code is the number of failures. Every
+ * generator is seeded from the seed (SHUF_SEED if there isn't one), so each
+ * run checks the same shuffles and a failure can be run again.
+ *
+ * Before any of that the random number streams are checked for coming out
+ * the same every time: rng_split() children have to match no matter what
+ * order they're split off in, differ from each other and from the parent,
+ * rng_jump()/rng_long_jump() have to land where the xoshiro256** reference
+ * code does, and seeding an RngBulk has to move its source stream on.
+ *
+ * Any new shuffle just needs adding to s_shuffles below to be checked the
+ * same way.
+ *****/
+
+#define SHUF_DEFAULT_N 1000000
+#define SHUF_FAIL_P 0.0001
+#define SHUF_SEED 20240101 // Default seed, so a run can be done again
+#define SHUF_SPLITS 8 // Children split off a parent by the stream checks
+
+typedef struct {
+    char *name;
+    void (*shuffle)(Deck *deck);
+} ShuffleFn;
+
+static Rng s_mt, s_xoshiro;
+static RngBulk s_bulk;
+
+static void shuffle_mt(Deck *deck) {
+    shuffle_deck_rng(deck, &s_mt);
+}
+
+static void shuffle_xoshiro(Deck *deck) {
+    shuffle_deck_rng(deck, &s_xoshiro);
+}
+
+static void shuffle_bulk(Deck *deck) {
+    shuffle_deck_bulk(deck, &s_bulk);
+}
+
+static ShuffleFn s_shuffles[] = {
+    {"shuffle_deck", &shuffle_deck},
+    {"shuffle_deck_rng, MT19937", &shuffle_mt},
+    {"shuffle_deck_rng, xoshiro256**", &shuffle_xoshiro},
+    {"shuffle_deck_bulk", &shuffle_bulk},
+};
+
+static long s_pos[DECK_CARDS][DECK_CARDS]; // [card id][position]
+static long s_pair[DECK_CARDS][DECK_CARDS]; // [card id][id of the next card]
+
+static double chi_square_p(double chi2, long df) {
+    /* Chance of a chi-square at least this big if the shuffle really is fair.
+     * Wilson-Hilferty turns it into a normal z score, which is plenty close
+     * with this many degrees of freedom. */
+    double k = 2.0 / (9.0 * df);
+    double z = (cbrt(chi2 / df) - (1.0 - k)) / sqrt(k);
+    return 0.5 * erfc(z / sqrt(2.0));
+}
+
+static int shuffle_report(char *what, double chi2, long df) {
+    double p = chi_square_p(chi2, df);
+    bool fail = (p < SHUF_FAIL_P);
+    printf("  %-24s chi2 %10.1f  df %5ld  p %.4f  %s\n", what, chi2, df, p,
+            fail ? "FAIL" : "ok");
+    return fail;
+}
+
+static int test_shuffle(ShuffleFn *fn, Deck *deck, long n) {
+    Card *sorted[DECK_CARDS];
+    int id[DECK_CARDS];
+    double chi2 = 0.0, expect = 0.0, d = 0.0;
+    long i = 0, start = 0, us = 0;
+    int j = 0, k = 0, fails = 0;
+
+    printf("%s, %ld shuffles\n", fn->name, n);
+    memcpy(sorted, deck->cards, sizeof(sorted));
+    memset(s_pos, 0, sizeof(s_pos));
+    memset(s_pair, 0, sizeof(s_pair));
+    for(i = 0; i < n; i++) {
+        // Start from the same order every time, so any pull towards where the
+        // cards started shows up
+        memcpy(deck->cards, sorted, sizeof(sorted));
+        fn->shuffle(deck);
+        for(j = 0; j < DECK_CARDS; j++) {
+            id[j] = card_id(deck->cards[j]->flags);
+            s_pos[id[j]][j] += 1;
+        }
+        for(j = 1; j < DECK_CARDS; j++) {
+            s_pair[id[j - 1]][id[j]] += 1;
+        }
+    }
+
+    // Card/position: expect n/52 in every cell. Rows and columns both add up
+    // to n, so 51x51 degrees of freedom.
+    expect = (double)n / DECK_CARDS;
+    for(j = 0, chi2 = 0.0; j < DECK_CARDS; j++) {
+        for(k = 0; k < DECK_CARDS; k++) {
+            d = s_pos[j][k] - expect;
+            chi2 += (d * d) / expect;
+        }
+    }
+    fails += shuffle_report("Card position", chi2,
+            (DECK_CARDS - 1) * (DECK_CARDS - 1));
+
+    // Adjacent pairs: 51 pairs a shuffle spread over 52x51 ordered pairs, so
+    // n/52 each. A card can't follow itself.
+    expect = (double)n / DECK_CARDS;
+    for(j = 0, chi2 = 0.0; j < DECK_CARDS; j++) {
+        for(k = 0; k < DECK_CARDS; k++) {
+            if(j == k) continue;
+            d = s_pair[j][k] - expect;
+            chi2 += (d * d) / expect;
+        }
+    }
+    fails += shuffle_report("Adjacent pairs", chi2,
+            (DECK_CARDS * (DECK_CARDS - 1)) - 1);
+
+    // Top card, which is just the first column of the position table
+    for(j = 0, chi2 = 0.0; j < DECK_CARDS; j++) {
+        d = s_pos[j][0] - expect;
+        chi2 += (d * d) / expect;
+    }
+    fails += shuffle_report("First card", chi2, DECK_CARDS - 1);
+
+    // Speed, without the counting getting in the way
+    start = loop_us();
+    for(i = 0; i < n; i++) {
+        fn->shuffle(deck);
+    }
+    us = loop_us() - start;
+    printf("  %-24s %.0f shuffles/s (%.1fns each)\n", "Throughput",
+            us ? (n * 1000000.0) / us : 0.0, (us * 1000.0) / n);
+    memcpy(deck->cards, sorted, sizeof(sorted));
+    return fails;
+}
+
+static int rng_report(char *what, bool ok) {
+    printf("  %-24s %s\n", what, ok ? "ok" : "FAIL");
+    return !ok;
+}
+
+static int test_rng_split(RngKind kind) {
+    /* Split children off the same parent front to back and back to front,
+     * the first numbers out of each have to be the same both ways. */
+    Rng parent, before, child;
+    uint64_t fwd[SHUF_SPLITS], back[SHUF_SPLITS], first = 0;
+    bool same = true, differ = true;
+    int i = 0, j = 0, fails = 0;
+
+    rng_init_kind(&parent, kind, 2024);
+    before = parent;
+    for(i = 0; i < SHUF_SPLITS; i++) {
+        rng_split(&child, &parent, i);
+        fwd[i] = rng_u64(&child);
+    }
+    for(i = SHUF_SPLITS - 1; i >= 0; i--) {
+        rng_split(&child, &parent, i);
+        back[i] = rng_u64(&child);
+    }
+    first = rng_u64(&parent);
+    for(i = 0; i < SHUF_SPLITS; i++) {
+        if(fwd[i] != back[i]) same = false;
+        if(fwd[i] == first) differ = false;
+        for(j = 0; j < i; j++) {
+            if(fwd[i] == fwd[j]) differ = false;
+        }
+    }
+    fails += rng_report("Split in any order", same);
+    fails += rng_report("Children all differ", differ);
+    fails += rng_report("Split leaves parent", first == rng_u64(&before));
+    return fails;
+}
+
+static int test_rng_jump(void) {
+    /* Known answers for state {1, 2, 3, 4}, from the xoshiro256** reference
+     * jump()/long_jump() (and double checked by raising the generator's
+     * GF(2) matrix to 2^128 and 2^192). */
+    static const uint64_t jump[4] = { 0x8c7a153956b5f3d1ULL,
+        0x701f1a713401d85eULL, 0x6527f66a65469085ULL, 0x8386b786c4408050ULL };
+    static const uint64_t long_jump[4] = { 0x096a8eb71295a400ULL,
+        0xdbf84991e50f4516ULL, 0x534ee745810d2a0eULL, 0x31655ca1a2215bf1ULL };
+    Rng rng = { .kind = RNG_XOSHIRO, .xs = { 1, 2, 3, 4 } };
+    int fails = 0;
+
+    rng_jump(&rng);
+    fails += rng_report("Jump, 2^128",
+            memcmp(rng.xs, jump, sizeof(jump)) == 0);
+    rng = (Rng){ .kind = RNG_XOSHIRO, .xs = { 1, 2, 3, 4 } };
+    rng_long_jump(&rng);
+    fails += rng_report("Long jump, 2^192",
+            memcmp(rng.xs, long_jump, sizeof(long_jump)) == 0);
+    return fails;
+}
+
+static int test_rng_bulk(void) {
+    // The stream a bulk is seeded from mustn't go on to repeat lane 0
+    Rng rng;
+    RngBulk bulk;
+    uint32_t lane = 0;
+    rng_init_kind(&rng, RNG_XOSHIRO, 2024);
+    rng_bulk_init_rng(&bulk, &rng);
+    rng_fill_u32(&bulk, &lane, 1);
+    return rng_report("Bulk moves source on", lane != (uint32_t)rng_u64(&rng));
+}
+
+int run_shuffle_test(long n, unsigned long seed) {
+    Arena *arena = create_arena(arena_size_for(deck_size_for(DECK_CARDS), 1) +
+            arena_size_for(sizeof(Card), DECK_CARDS));
+    Deck *deck = create_deck_in(arena, DECK_CARDS);
+    int i = 0, fails = 0;
+
+    if(n <= 0) n = SHUF_DEFAULT_N;
+    if(seed == 0) seed = SHUF_SEED;
+    printf("Seed %lu (\"--shuffle-test %ld %lu\" runs this again)\n", seed, n,
+            seed);
+    printf("Random number streams, xoshiro256**\n");
+    fails += test_rng_split(RNG_XOSHIRO);
+    fails += test_rng_jump();
+    fails += test_rng_bulk();
+    printf("Random number streams, MT19937\n");
+    fails += test_rng_split(RNG_MT19937);
+    // Everything is seeded from the one seed, g_rng too (for shuffle_deck())
+    rng_init(&g_rng, seed);
+    rng_init_kind(&s_mt, RNG_MT19937, rng_u32(&g_rng));
+    rng_init_kind(&s_xoshiro, RNG_XOSHIRO, rng_u32(&g_rng));
+    rng_bulk_init(&s_bulk, rng_u32(&g_rng));
+    fill_deck_in(deck, arena);
+    for(i = 0; i < sizeof(s_shuffles) / sizeof(ShuffleFn); i++) {
+        fails += test_shuffle(&s_shuffles[i], deck, n);
+    }
+    destroy_arena(arena);
+    printf("%s\n", fails ? "FAILED" : "All shuffles look fair");
+    return fails;
+}
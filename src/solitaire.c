@@ -21,25 +21,53 @@
 #include <sys/time.h>
 #include <ctype.h>
 
+static void solitaire_carve(Solitaire *game) {
+    /* (Re)make the shoe, the empty decks and the undo journal out of the
+     * game's arena. Every deck has room for the whole shoe. */
+    uint8_t i = 0;
+    game->shoe = create_shoe_in(game->arena, game->shoe_decks);
+    journal_init(&game->journal, arena_alloc(game->arena,
+                sizeof(JournalEntry) * JOURNAL_MAX), JOURNAL_MAX);
+    for(i = 0; i < game->num_decks; i++) {
+        game->decks[i] = create_deck_in(game->arena, game->shoe->size);
+        game->decks[i]->id = i;
+    }
+}
+
 Solitaire* create_solitaire(uint8_t num_decks) {
+    // The usual, one deck of cards
+    return create_solitaire_shoe(num_decks, 1);
+}
+
+Solitaire* create_solitaire_shoe(uint8_t num_decks, uint8_t shoe_decks) {
+    /* A solitaire game with num_decks piles, played with shoe_decks standard
+     * decks of cards (two for Spider or double Klondike) */
     uint8_t i = 0;
     Solitaire *game = malloc(sizeof(Solitaire));
-    game->events = NULL;
-    game->update = NULL;
-    game->draw = NULL;
+    // Same limits as create_shoe_in(), before the arena is sized for it
+    if(shoe_decks < 1) shoe_decks = 1;
+    if(shoe_decks > SHOE_MAX_DECKS) shoe_decks = SHOE_MAX_DECKS;
+    game->layout = NULL;
     game->flags = GFL_NONE;
+    game->loop = create_game_loop(&game->flags);
     game->score = 0;
     game->num_decks = num_decks;
+    game->shoe_decks = shoe_decks;
     game->decks = malloc(sizeof(Deck*) * num_decks);
     game->btns = malloc(sizeof(Button*) * num_decks);
+    // One block for all of the decks and the cards, see solitaire_carve()
+    game->arena = create_arena(shoe_size_for(shoe_decks) + num_decks *
+            arena_size_for(deck_size_for(DECK_CARDS * shoe_decks), 1) +
+            arena_size_for(sizeof(JournalEntry) * JOURNAL_MAX, 1));
+    solitaire_carve(game);
     for(i = 0; i < num_decks; i++) {
-        game->decks[i] = create_deck();
-        game->decks[i]->id = i;
         game->btns[i] = create_button(0,0,i,'a'+i);
     }
     game->fromref = NULL;
     game->toref = NULL;
-    game->msg = NULL;
+    game->msg[0] = '\0';
+    game->msgtimer = -1;
+    game->hits = create_hitgrid();
     return game;
 }
 
@@ -47,22 +75,21 @@ void destroy_solitaire(Solitaire *game) {
     if(!game) return;
     uint8_t i = 0;
     for(i = 0; i < game->num_decks; i++) {
-        if(game->decks) {
-            destroy_deck(game->decks[i]);
-        }
         if(game->btns) {
             destroy_button(game->btns[i]);
         }
     }
+    // The decks and cards all live in the arena
+    destroy_arena(game->arena);
+    game->arena = NULL;
     if(game->decks) {
         free(game->decks);
     }
     if(game->btns) {
         free(game->btns);
     }
-    if(game->msg) {
-        free(game->msg);
-    }
+    destroy_hitgrid(game->hits);
+    destroy_game_loop(game->loop);
     game->decks = NULL;
     game->btns = NULL;
     game->fromref = NULL;
@@ -70,17 +97,122 @@ void destroy_solitaire(Solitaire *game) {
     free(game);
 }
 
-void solitaire_msg(Solitaire *g, char *msg,...) {
-    if(g->msg) {
-        free(g->msg);
-        g->msg = NULL;
+void reset_solitaire(Solitaire *game) {
+    /* Start a new game in the same Solitaire - the arena is reset (which
+     * throws out every deck and card at once) and the decks are carved out of
+     * it again, nothing is freed or allocated. Buttons go back to the way
+     * create_solitaire() made them, so the game's init can set them up. */
+    uint8_t i = 0;
+    if(!game) return;
+    arena_reset(game->arena);
+    solitaire_carve(game);
+    for(i = 0; i < game->num_decks; i++) {
+        game->btns[i]->x = 0;
+        game->btns[i]->y = 0;
+        game->btns[i]->ch = 'a' + i;
+        game->btns[i]->active = false;
+        game->btns[i]->selected = false;
     }
-    if(!msg) return;
+    game_loop_reset(game->loop);
+    game->msgtimer = -1;
+    game->msg[0] = '\0';
+    game->fromref = NULL;
+    game->toref = NULL;
+    game->flags = GFL_NONE;
+    game->score = 0;
+    game->hits->valid = false; // Rebuilt on the next click
+}
+
+/*****
+ * Moves. Everything a game does to the piles (after the deal) or the score
+ * goes through these, so it ends up in the journal and can be undone.
+ *****/
+bool solitaire_move(Solitaire *g, Deck *from, int i, Deck *to, bool reverse) {
+    // Move from->cards[i] and everything after it to "to", see splice_cards()
+    int n = from->count - i;
+    if(!splice_cards(from, i, to, reverse)) return false;
+    journal_add(&g->journal, reverse ? JR_MOVE_REV : JR_MOVE, from->id, to->id,
+            n, 0);
+    return true;
+}
+
+void solitaire_draw(Solitaire *g, Deck *from, Deck *to, int n) {
+    // Draw n cards off the top of "from", see draw_cards()
+    int before = to->count;
+    draw_cards(from, to, n);
+    n = to->count - before;
+    if(n) journal_add(&g->journal, JR_DRAW, from->id, to->id, n, 0);
+}
+
+void solitaire_flip(Solitaire *g, Deck *deck, int i) {
+    // Turn deck->cards[i] face up
+    Card *card = get_card_at(deck, i);
+    if(!card || check_flag(card->flags, CD_UP)) return;
+    engage_flag(&card->flags, CD_UP);
+    journal_add(&g->journal, JR_FLIP, deck->id, deck->id, i, 0);
+}
+
+void solitaire_swap(Solitaire *g, Deck *a, int i, Deck *b, int j) {
+    // Trade a->cards[i] and b->cards[j]
+    if(!get_card_at(a, i) || !get_card_at(b, j)) return;
+    swap_cards(a, i, b, j);
+    journal_add(&g->journal, JR_SWAP, a->id, b->id, i, j);
+}
+
+void solitaire_score(Solitaire *g, int points) {
+    g->score += points;
+    journal_add(&g->journal, JR_SCORE, 0, 0, 0, points);
+}
+
+static void solitaire_deselect(Solitaire *g) {
+    // Drop a half finished move, undo/redo change what it would have moved
+    uint8_t i = 0;
+    for(i = 0; i < g->num_decks; i++) {
+        g->btns[i]->selected = false;
+    }
+    g->fromref = NULL;
+    g->toref = NULL;
+}
+
+void solitaire_undo(Solitaire *g) {
+    solitaire_deselect(g);
+    if(journal_undo(&g->journal, g->decks, &g->score)) {
+        solitaire_msg(g, "Undid the last move.");
+    } else {
+        solitaire_msg(g, "Nothing to undo.");
+    }
+    g->flags |= GFL_DRAW;
+}
+
+void solitaire_redo(Solitaire *g) {
+    solitaire_deselect(g);
+    if(journal_redo(&g->journal, g->decks, &g->score)) {
+        solitaire_msg(g, "Redid the move.");
+    } else {
+        solitaire_msg(g, "Nothing to redo.");
+    }
+    g->flags |= GFL_DRAW;
+}
+
+static void solitaire_msg_expire(void *data) {
+    // Timer callback, the message has been up long enough
+    Solitaire *g = data;
+    g->msgtimer = -1;
+    g->msg[0] = '\0';
+    g->flags |= GFL_DRAW;
+}
+
+void solitaire_msg(Solitaire *g, char *msg,...) {
+    /* Show a message under the cards. It goes away by itself after
+     * SOL_MSG_MS, or when it's replaced by another message. */
     va_list args;
+    game_loop_cancel(g->loop, g->msgtimer);
+    g->msgtimer = -1;
+    g->msg[0] = '\0';
+    if(!msg) return;
+    g->msgtimer = game_loop_after(g->loop, SOL_MSG_MS, &solitaire_msg_expire, g);
     va_start(args,msg);
-    int i = strlen(msg) + 1;
-    g->msg = malloc(sizeof(char) * i);
-    vsnprintf(g->msg,i,msg,args);
+    vsnprintf(g->msg,SOL_MSG_SZ,msg,args);
     va_end(args);
 }
 
@@ -91,36 +223,26 @@ long current_ms(void) {
     return ((tp.tv_sec * 1000) + (tp.tv_usec / 1000));
 }
 
-void solitaire_loop(Solitaire *g) {
-    /* Overdesigned main loop? Probably. This is your standard,
-     * events-update-render loop with a nice check to keep it at a steady
-     * 30fps (otherwise it will render as fast as it can draw, and since this
-     * isn't a very processor intensive program at all - it can look blinky) 
-     * Update: this doesn't stop it looking blinky. Fairly certain the way I'm
-     * using escape codes to clear/refresh the screen is causing the blinky.
-     * Current fix is only drawing the screen when the game does something that
-     * would make the display change.*/
-    long prev = current_ms();
-    long lag = 0, current = 0, elapsed = 0;
-    long msperframe = 33; // 16ms = ~60fps, 33ms = ~30fps
-    g->flags |= GFL_RUNNING;
-    while(check_flag(g->flags, GFL_RUNNING)) {
-        current = current_ms();
-        elapsed = current - prev;
-        prev = current;
-        lag += elapsed;
-        g->events();
-        g->update();
-        if(check_flag(g->flags,GFL_DRAW)) {
-            g->draw();
-        }
-        if(check_flag(g->flags,GFL_RESTART)) {
-            g->flags &= ~GFL_RUNNING;
-        }
-        while(lag >= msperframe) {
-            lag -= msperframe;
-        }
+bool solitaire_click(Solitaire *g, KeyEvent *key) {
+    /* Turn a mouse click into the key for the pile/button under it. Where
+     * things are drawn only depends on how many cards are in each deck (and
+     * whether the game has been won), so that is the layout stamp - the hit
+     * grid is only rebuilt when one of those changes. Counts go past 255 with
+     * a multi-deck shoe, so each one takes two bytes. */
+    uint8_t stamp[HG_STAMPSZ];
+    int i = 0;
+    if(!g->layout) return false;
+    memset(stamp, 0, HG_STAMPSZ);
+    for(i = 0; (i < g->num_decks) && (2 * i + 1 < HG_STAMPSZ - 1); i++) {
+        stamp[2 * i] = g->decks[i]->count & 0xff;
+        stamp[2 * i + 1] = g->decks[i]->count >> 8;
+    }
+    stamp[HG_STAMPSZ - 1] = check_flag(g->flags, GFL_WIN);
+    if(hitgrid_stale(g->hits, stamp)) {
+        hitgrid_clear(g->hits);
+        g->layout(g->hits);
     }
+    return hitgrid_click(g->hits, key);
 }
 
 void solitaire_pause(Solitaire *g) {
@@ -170,45 +292,16 @@ void solitaire_pause(Solitaire *g) {
     destroy_slist(&menu);
 }
 
-char solitaire_prompt(char *fstr, ...) {
+void solitaire_prompt(Solitaire *g, PromptFn fn, char *fstr, ...) {
     /*
-     * Draw a prompt at the bottom of the screen, and wait for the user to
-     * keypress, then return the char of that keypress (uppercase)
-     *
-     * Note: Need to make sure to turn on the GFL_DRAW flag, and call the
-     * solitaire's draw routine PRIOR to calling this. This seemed like a better
-     * solution than passing in a pointer to the solitaire game that was calling
-     * the function.
+     * Ask a question at the bottom of the screen. This doesn't wait for the
+     * answer - the game keeps running, and fn gets called with the key the
+     * player pressed (uppercase) once they do. Nothing else happens in the
+     * game until then.
      */
-    char result = '\0';
-    int xo = (g_screenW / 2) - (SCREEN_WIDTH / 2); // Standard screen size is 80x24, defined in glyph.c
-    int yo = (g_screenH / 2) - (SCREEN_HEIGHT / 2);
-    if(!fstr) return result;
-
-    // Draw a blank line to "erase" the bottom of the screen
-    char *prompt = malloc(SCREEN_WIDTH * sizeof(char));
-    memset(prompt, ' ', SCREEN_WIDTH - 2);
-    prompt[SCREEN_WIDTH - 2] = '\0';
-    scr_pt_clr(0+xo,23+yo,WHITE,BLACK,prompt); 
-
-    // Format the prompt
     va_list args;
+    if(!fstr) return;
     va_start(args,fstr);
-    vsnprintf(prompt,SCREEN_WIDTH,fstr,args);
+    game_loop_vprompt(g->loop, fn, NULL, fstr, args);
     va_end(args);
-
-    // Print the prompt
-    scr_pt_clr(xo,23+yo,WHITE,BLACK,prompt);
-
-    // Show the blinking cursor
-    // Get a char from the user
-    result = kb_get_bl_char_cursor(xo+strlen(fstr)+1,23+yo);
-
-    // Change result to upper case
-    if(result) {
-        result = toupper(result);
-    }
-
-    free(prompt);
-    return result;
 }
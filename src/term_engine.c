@@ -19,6 +19,11 @@
 */
 
 #include <term_engine.h>
+#include <poll.h>
+#include <errno.h>
+#include <sys/signalfd.h>
+#include <sys/timerfd.h>
+#include <sys/uio.h>
 
 /******
  * Terminal Engine
@@ -38,17 +43,78 @@ struct termios g_oldkbflags;
 int g_screenW = 0;
 int g_screenH = 0;
 
+/*
+ * The event loop waits on three file descriptors with poll(): stdin, a timerfd
+ * for scheduled work, and a signalfd that turns SIGWINCH into something poll()
+ * can see. Nothing wakes up unless a key is pressed, a timer expires, or the
+ * terminal is resized - an idle game sits at 0% CPU.
+ */
+static int s_sigfd = -1;
+static int s_timerfd = -1;
+static volatile sig_atomic_t s_resized = 0;
+
+/*
+ * Keyboard input is read in bulk into a ring of raw bytes, and a small state
+ * machine turns those bytes into KeyEvents (plain characters, UTF-8, CSI/SS3
+ * escape sequences, or a bare Esc once KB_ESC_DELAY passes with nothing after
+ * it). Both rings are powers of two so indices just get masked.
+ */
+#define KB_BUFSZ 256
+#define KB_KEYSZ 64
+#define KB_ESC_DELAY 50 // ms to wait before deciding an Esc is just an Esc
+#define KB_MAXPARAMS 4
+
+typedef enum {
+    KS_GROUND = 0,
+    KS_ESC,
+    KS_CSI,
+    KS_SS3,
+    KS_UTF8
+} KbState;
+
+static uint8_t s_kbbuf[KB_BUFSZ];
+static unsigned int s_kbhead = 0, s_kbtail = 0;
+static KeyEvent s_keys[KB_KEYSZ];
+static unsigned int s_keyhead = 0, s_keytail = 0;
+static KbState s_kbstate = KS_GROUND;
+static long s_kbesc_ms = 0;
+static int s_params[KB_MAXPARAMS];
+static int s_nparams = 0;
+static char s_csipriv = '\0';
+static int s_utf8cp = 0;
+static int s_utf8left = 0;
+static unsigned int s_kbblocks = 0; // Number of blocking reads so far
+static long s_kbread_us = 0; // When the bytes being decoded were read
+
+static long mono_ms(void);
+static long mono_us(void);
+static int kb_esc_timeout(void);
+static void kb_fill(void);
+static void kb_decode(void);
+static void kb_expire_esc(void);
+
 /******************
  * System functions
  ******************/
 void term_init(void) {
-    //signal(SIGWINCH, term_resize); //Works but depreciated?
-    // This replaces the signal call above
-    struct sigaction resize_action;
-    resize_action.sa_handler = term_resize;
-    sigemptyset(&resize_action.sa_mask);
-    resize_action.sa_flags = 0;
-    sigaction(SIGWINCH, &resize_action, NULL);
+    // SIGWINCH is blocked and read from a signalfd, so a resize shows up as a
+    // regular poll() event instead of interrupting whatever is running.
+    sigset_t mask;
+    sigemptyset(&mask);
+    sigaddset(&mask, SIGWINCH);
+    if(sigprocmask(SIG_BLOCK, &mask, NULL) == 0) {
+        s_sigfd = signalfd(-1, &mask, SFD_NONBLOCK | SFD_CLOEXEC);
+    }
+    if(s_sigfd == -1) {
+        // No signalfd, fall back to a plain signal handler
+        sigprocmask(SIG_UNBLOCK, &mask, NULL);
+        struct sigaction resize_action;
+        resize_action.sa_handler = term_resize;
+        sigemptyset(&resize_action.sa_mask);
+        resize_action.sa_flags = 0;
+        sigaction(SIGWINCH, &resize_action, NULL);
+    }
+    s_timerfd = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC);
 
     // Init the screen and keyboard
     scr_init();
@@ -58,6 +124,14 @@ void term_init(void) {
 void term_close(void) {
     scr_restore();
     kb_restore();
+    if(s_timerfd != -1) {
+        close(s_timerfd);
+        s_timerfd = -1;
+    }
+    if(s_sigfd != -1) {
+        close(s_sigfd);
+        s_sigfd = -1;
+    }
 }
 
 void term_resize(int i) {
@@ -66,6 +140,81 @@ void term_resize(int i) {
     ioctl(0,TIOCGWINSZ,&ws);
     g_screenW = ws.ws_col;
     g_screenH = ws.ws_row;
+    s_resized = 1;
+}
+
+int term_wait(int timeout) {
+    /* Sleep until there is input on stdin, the timer expires, or the terminal
+     * is resized, or until timeout ms have passed (-1 waits forever, 0 just
+     * checks). Returns a mask of TermEvents, TE_NONE on timeout. */
+    struct pollfd fds[3];
+    struct signalfd_siginfo si;
+    uint64_t expirations = 0;
+    int nfds = 0, result = TE_NONE, i = 0;
+
+    fds[nfds].fd = STDIN_FILENO;
+    fds[nfds].events = POLLIN;
+    nfds++;
+    if(s_timerfd != -1) {
+        fds[nfds].fd = s_timerfd;
+        fds[nfds].events = POLLIN;
+        nfds++;
+    }
+    if(s_sigfd != -1) {
+        fds[nfds].fd = s_sigfd;
+        fds[nfds].events = POLLIN;
+        nfds++;
+    }
+    for(i = 0; i < nfds; i++) {
+        fds[i].revents = 0;
+    }
+
+    // Keys that are already decoded don't need to wait for anything, and a
+    // half finished escape sequence only gets KB_ESC_DELAY to finish.
+    if(kb_pending()) {
+        timeout = 0;
+        result |= TE_INPUT;
+    } else if((i = kb_esc_timeout()) >= 0) {
+        if((timeout < 0) || (i < timeout)) timeout = i;
+    }
+
+    if(!s_resized && poll(fds, nfds, timeout) == -1 && errno != EINTR) {
+        return result;
+    }
+
+    if(fds[0].revents & (POLLIN | POLLHUP | POLLERR)) {
+        result |= TE_INPUT;
+    }
+    for(i = 1; i < nfds; i++) {
+        if(!(fds[i].revents & POLLIN)) continue;
+        if(fds[i].fd == s_timerfd) {
+            // Drain the expiration count so the fd stops being readable
+            if(read(s_timerfd, &expirations, sizeof(expirations)) > 0) {
+                result |= TE_TIMER;
+            }
+        } else if(fds[i].fd == s_sigfd) {
+            while(read(s_sigfd, &si, sizeof(si)) == sizeof(si)) {
+                term_resize(0);
+            }
+        }
+    }
+    if(s_resized) {
+        s_resized = 0;
+        result |= TE_RESIZE;
+    }
+    return result;
+}
+
+void term_set_timer(long ms) {
+    /* Arm the one shot timer to fire in ms milliseconds, ms <= 0 disarms it */
+    struct itimerspec its;
+    if(s_timerfd == -1) return;
+    memset(&its, 0, sizeof(its));
+    if(ms > 0) {
+        its.it_value.tv_sec = ms / 1000;
+        its.it_value.tv_nsec = (ms % 1000) * 1000000L;
+    }
+    timerfd_settime(s_timerfd, 0, &its, NULL);
 }
 
 /******************
@@ -279,38 +428,324 @@ void kb_init(void) {
         newkbflags.c_lflag &= ~ICANON;
         newkbflags.c_lflag &= ~ECHO;
         newkbflags.c_cc[VMIN] = 0;
-        newkbflags.c_cc[VTIME] = 1;
+        newkbflags.c_cc[VTIME] = 0;
         tcsetattr(0, TCSANOW, &newkbflags);
     }
+    printf("\x1b[?1000h\x1b[?1006h"); // Report mouse clicks, SGR style
+    fflush(stdout);
 }
 
 void kb_restore(void) {
+    printf("\x1b[?1006l\x1b[?1000l"); // Stop reporting the mouse
+    fflush(stdout);
     tcsetattr(0,TCSADRAIN,&g_oldkbflags);
 }
 
+static long mono_ms(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (ts.tv_sec * 1000) + (ts.tv_nsec / 1000000);
+}
+
+static long mono_us(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (ts.tv_sec * 1000000) + (ts.tv_nsec / 1000);
+}
+
+static void kb_push_key(int key, int mods) {
+    if((s_keytail - s_keyhead) >= KB_KEYSZ) return; // Full, drop it
+    s_keys[s_keytail & (KB_KEYSZ - 1)].key = key;
+    s_keys[s_keytail & (KB_KEYSZ - 1)].mods = mods;
+    s_keys[s_keytail & (KB_KEYSZ - 1)].x = 0;
+    s_keys[s_keytail & (KB_KEYSZ - 1)].y = 0;
+    s_keys[s_keytail & (KB_KEYSZ - 1)].us = s_kbread_us;
+    s_keytail++;
+}
+
+static void kb_finish_mouse(uint8_t final) {
+    /* SGR mouse report: ESC [ < button ; x ; y M (press) or m (release), with
+     * x/y starting at 1. Only presses of the left button become KEY_MOUSE -
+     * releases, motion, wheel and the other buttons are dropped here so they
+     * never wake up the game. */
+    int btn = (s_nparams > 0) ? s_params[0] : 0;
+    if((final != 'M') || (s_nparams < 3)) return;
+    if(btn & (32 | 64)) return; // Motion or wheel
+    if((btn & 3) != 0) return; // Not the left button
+    if((s_keytail - s_keyhead) >= KB_KEYSZ) return; // Full, drop it
+    kb_push_key(KEY_MOUSE, (btn >> 2) & (KM_SHIFT | KM_ALT | KM_CTRL));
+    s_keys[(s_keytail - 1) & (KB_KEYSZ - 1)].x = s_params[1] - 1;
+    s_keys[(s_keytail - 1) & (KB_KEYSZ - 1)].y = s_params[2] - 1;
+}
+
+static void kb_fill(void) {
+    /* Pull everything that is waiting on stdin into the byte ring with a
+     * single readv() - two iovecs when the free space wraps around. */
+    struct iovec iov[2];
+    unsigned int used = s_kbtail - s_kbhead;
+    unsigned int space = KB_BUFSZ - used;
+    unsigned int start = s_kbtail & (KB_BUFSZ - 1);
+    unsigned int first = KB_BUFSZ - start;
+    ssize_t n = 0;
+    if(!space) return;
+    if(first > space) first = space;
+    iov[0].iov_base = &s_kbbuf[start];
+    iov[0].iov_len = first;
+    iov[1].iov_base = s_kbbuf;
+    iov[1].iov_len = space - first;
+    n = readv(STDIN_FILENO, iov, (space > first) ? 2 : 1);
+    if(n > 0) {
+        s_kbtail += n;
+        s_kbread_us = mono_us(); // Keys decoded from these bytes get this time
+    }
+}
+
+static int kb_csi_mods(int param) {
+    // xterm sends modifiers as 1 + (shift | alt << 1 | ctrl << 2)
+    return (param > 1) ? ((param - 1) & (KM_SHIFT | KM_ALT | KM_CTRL)) : KM_NONE;
+}
+
+static void kb_finish_csi(uint8_t final) {
+    int key = KEY_UNKNOWN;
+    int p0 = (s_nparams > 0) ? s_params[0] : 0;
+    int mods = (s_nparams > 1) ? kb_csi_mods(s_params[1]) : KM_NONE;
+    if(s_csipriv == '<') {
+        kb_finish_mouse(final);
+        return;
+    } else if(s_csipriv != '\0') {
+        // Other private sequences aren't keys
+        return;
+    }
+    switch(final) {
+        case 'A': key = KEY_UP; break;
+        case 'B': key = KEY_DOWN; break;
+        case 'C': key = KEY_RIGHT; break;
+        case 'D': key = KEY_LEFT; break;
+        case 'H': key = KEY_HOME; break;
+        case 'F': key = KEY_END; break;
+        case 'Z': key = KEY_BACKTAB; break;
+        case 'P': key = KEY_F1; break;
+        case 'Q': key = KEY_F2; break;
+        case 'R': key = KEY_F3; break;
+        case 'S': key = KEY_F4; break;
+        case '~':
+            switch(p0) {
+                case 1: case 7: key = KEY_HOME; break;
+                case 2: key = KEY_INSERT; break;
+                case 3: key = KEY_DELETE; break;
+                case 4: case 8: key = KEY_END; break;
+                case 5: key = KEY_PGUP; break;
+                case 6: key = KEY_PGDN; break;
+                case 11: key = KEY_F1; break;
+                case 12: key = KEY_F2; break;
+                case 13: key = KEY_F3; break;
+                case 14: key = KEY_F4; break;
+                case 15: key = KEY_F5; break;
+                case 17: key = KEY_F6; break;
+                case 18: key = KEY_F7; break;
+                case 19: key = KEY_F8; break;
+                case 20: key = KEY_F9; break;
+                case 21: key = KEY_F10; break;
+                case 23: key = KEY_F11; break;
+                case 24: key = KEY_F12; break;
+                default: break;
+            }
+            break;
+        default: break;
+    }
+    kb_push_key(key, mods);
+}
+
+static void kb_finish_ss3(uint8_t final) {
+    int key = KEY_UNKNOWN;
+    switch(final) {
+        case 'A': key = KEY_UP; break;
+        case 'B': key = KEY_DOWN; break;
+        case 'C': key = KEY_RIGHT; break;
+        case 'D': key = KEY_LEFT; break;
+        case 'H': key = KEY_HOME; break;
+        case 'F': key = KEY_END; break;
+        case 'M': key = KEY_ENTER; break;
+        case 'P': key = KEY_F1; break;
+        case 'Q': key = KEY_F2; break;
+        case 'R': key = KEY_F3; break;
+        case 'S': key = KEY_F4; break;
+        default: break;
+    }
+    kb_push_key(key, KM_NONE);
+}
+
+static void kb_ground_byte(uint8_t c, int mods) {
+    /* A byte seen outside of any sequence */
+    if(c < 0x80) {
+        kb_push_key((c == '\r') ? KEY_ENTER : c, mods);
+    } else if((c >= 0xC2) && (c <= 0xDF)) {
+        s_utf8cp = c & 0x1F;
+        s_utf8left = 1;
+        s_kbstate = KS_UTF8;
+    } else if((c >= 0xE0) && (c <= 0xEF)) {
+        s_utf8cp = c & 0x0F;
+        s_utf8left = 2;
+        s_kbstate = KS_UTF8;
+    } else if((c >= 0xF0) && (c <= 0xF4)) {
+        s_utf8cp = c & 0x07;
+        s_utf8left = 3;
+        s_kbstate = KS_UTF8;
+    } else {
+        kb_push_key(0xFFFD, mods); // Stray continuation/invalid lead byte
+    }
+}
+
+static void kb_decode(void) {
+    /* Run every buffered byte through the state machine */
+    uint8_t c = 0;
+    while(s_kbhead != s_kbtail) {
+        c = s_kbbuf[s_kbhead & (KB_BUFSZ - 1)];
+        s_kbhead++;
+        switch(s_kbstate) {
+            case KS_GROUND:
+                if(c == KEY_ESC) {
+                    s_kbstate = KS_ESC;
+                    s_kbesc_ms = mono_ms();
+                } else {
+                    kb_ground_byte(c, KM_NONE);
+                }
+                break;
+            case KS_ESC:
+                if(c == '[') {
+                    s_kbstate = KS_CSI;
+                    s_nparams = 0;
+                    s_csipriv = '\0';
+                    memset(s_params, 0, sizeof(s_params));
+                } else if(c == 'O') {
+                    s_kbstate = KS_SS3;
+                } else if(c == KEY_ESC) {
+                    // Esc Esc: the first one was a real Esc
+                    kb_push_key(KEY_ESC, KM_NONE);
+                    s_kbesc_ms = mono_ms();
+                } else {
+                    // Esc + key is how terminals send Alt + key
+                    s_kbstate = KS_GROUND;
+                    kb_ground_byte(c, KM_ALT);
+                }
+                break;
+            case KS_CSI:
+                if((c >= '0') && (c <= '9')) {
+                    if(!s_nparams) s_nparams = 1;
+                    if(s_nparams <= KB_MAXPARAMS) {
+                        s_params[s_nparams - 1] = 
+                            (s_params[s_nparams - 1] * 10) + (c - '0');
+                    }
+                } else if(c == ';') {
+                    if(!s_nparams) s_nparams = 1;
+                    s_nparams++;
+                } else if((c >= '<') && (c <= '?')) {
+                    s_csipriv = c;
+                } else if((c >= 0x40) && (c <= 0x7E)) {
+                    if(s_nparams > KB_MAXPARAMS) s_nparams = KB_MAXPARAMS;
+                    kb_finish_csi(c);
+                    s_kbstate = KS_GROUND;
+                } else if(c < 0x20) {
+                    // Garbage, give up on the sequence
+                    s_kbstate = KS_GROUND;
+                }
+                // Intermediate bytes (0x20-0x2F) are ignored
+                break;
+            case KS_SS3:
+                kb_finish_ss3(c);
+                s_kbstate = KS_GROUND;
+                break;
+            case KS_UTF8:
+                if((c & 0xC0) == 0x80) {
+                    s_utf8cp = (s_utf8cp << 6) | (c & 0x3F);
+                    if(--s_utf8left == 0) {
+                        kb_push_key(s_utf8cp, KM_NONE);
+                        s_kbstate = KS_GROUND;
+                    }
+                } else {
+                    // Truncated character, start over with this byte
+                    kb_push_key(0xFFFD, KM_NONE);
+                    s_kbstate = KS_GROUND;
+                    s_kbhead--;
+                }
+                break;
+            default:
+                s_kbstate = KS_GROUND;
+                break;
+        }
+    }
+}
+
+static int kb_esc_timeout(void) {
+    /* How many ms until a pending Esc should be reported as a bare Esc, or -1
+     * if no escape sequence is in progress. */
+    long left = 0;
+    if(s_kbstate == KS_GROUND || s_kbstate == KS_UTF8) return -1;
+    left = KB_ESC_DELAY - (mono_ms() - s_kbesc_ms);
+    return (left > 0) ? (int)left : 0;
+}
+
+static void kb_expire_esc(void) {
+    /* Nothing else showed up after an Esc, so it was the Esc key. Half an
+     * escape sequence after that long is garbage and just gets dropped. */
+    if(kb_esc_timeout() != 0) return;
+    if(s_kbstate == KS_ESC) {
+        kb_push_key(KEY_ESC, KM_NONE);
+    }
+    s_kbstate = KS_GROUND;
+}
+
+int kb_pending(void) {
+    /* Number of decoded keys waiting to be read */
+    return (int)(s_keytail - s_keyhead);
+}
+
+bool kb_get_key(KeyEvent *ev) {
+    /* Non-blocking: pop the next decoded key into ev, reading and decoding
+     * whatever is waiting on stdin first if the queue is empty. Returns false
+     * if there is nothing to read. */
+    if(!kb_pending()) {
+        kb_fill();
+        kb_decode();
+        kb_expire_esc();
+    }
+    if(!kb_pending()) return false;
+    if(ev) {
+        *ev = s_keys[s_keyhead & (KB_KEYSZ - 1)];
+    }
+    s_keyhead++;
+    return true;
+}
+
 char kb_get_char(void) {
-    /* The while loop below makes this function "blocking"; with it commented
-     * out this changes to "non-blocking". Could possibly add a bool "blocking"
-     * or something as a passed in variable? Or maybe make blocking/nonblocking
-     * they're own functions?
+    /* Non-blocking: returns the next plain ASCII key, or '\0' if nothing has
+     * been typed. Special keys (arrows, function keys) and non-ASCII
+     * characters are skipped over.
      *
-     * In kb_init(), the flags VMIN and VTIME are important here, VMIN causes
-     * read to return immediately with a keypress, and VTIME causes read to
-     * return after a 1/10th second delay with no keypress */
-    char c = '\0';
-    //while('\0' == c) {
-        read(STDIN_FILENO,&c,1);
-    //}
-    //c = getchar();
-    //fgets(&c, 2, stdin);
-    return c;
+     * Anything that wants to sleep until a key arrives should use term_wait()
+     * (or kb_get_bl_char(), which does) instead of polling this in a loop. */
+    KeyEvent ev;
+    while(kb_get_key(&ev)) {
+        if((ev.key > 0) && (ev.key < 0x80)) {
+            return (char)ev.key;
+        }
+    }
+    return '\0';
+}
+
+unsigned int kb_block_count(void) {
+    /* How many times something has blocked waiting for a key. Game loops use
+     * this to notice that a prompt took over the screen part way through
+     * handling a batch of keys. */
+    return s_kbblocks;
 }
 
 char kb_get_bl_char(void) {
     /* As above, but this blocks until input is recieved */
     char c = '\0';
-    while('\0' == c) {
-        read(STDIN_FILENO,&c,1);
+    s_kbblocks++;
+    while('\0' == (c = kb_get_char())) {
+        term_wait(-1);
     }
     return c;
 }
@@ -337,6 +772,7 @@ char* kb_get_str(int maxsz) {
      */
     char* input = malloc(maxsz * sizeof(char));
     //char c = '\0';
+    s_kbblocks++;
     kb_restore(); // Restore terminal keyboard
     printf("\x1b[?25h\x1b[1 q"); // Show the cursor
     /* Since scanf(...) is problematic, it **might** be better to rewrite this
@@ -0,0 +1,212 @@
+/*
+* Cards
+* Copyright (C) Zach Wilder 2024
+* 
+* This file is a part of Cards
+*
+* Cards is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+* 
+* Cards is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+* 
+* You should have received a copy of the GNU General Public License
+* along with Cards.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#include <cards.h>
+
+/* Timer ids handed out to callers are the pool index in the low byte, and the
+ * timer's generation above that, so cancelling a timer that already went off
+ * (and maybe got reused) does nothing. */
+#define TW_ID(i,g) ((int)(((g) << 8) | (i)))
+#define TW_ID_INDEX(id) ((id) & 0xFF)
+#define TW_ID_GEN(id) ((uint16_t)((id) >> 8))
+
+static void tw_link(TimerWheel *tw, int16_t i);
+static void tw_unlink(TimerWheel *tw, int16_t i);
+static void tw_release(TimerWheel *tw, int16_t i);
+static void tw_cascade(TimerWheel *tw, int level);
+
+static uint64_t rotr64(uint64_t x, int n) {
+    n &= 63;
+    return n ? ((x >> n) | (x << (64 - n))) : x;
+}
+
+void tw_init(TimerWheel *tw, long now_ms) {
+    int i = 0, j = 0;
+    for(i = 0; i < TW_LEVELS; i++) {
+        for(j = 0; j < TW_SLOTS; j++) {
+            tw->slots[i][j] = -1;
+        }
+        tw->used[i] = 0;
+    }
+    for(i = 0; i < TW_MAX_TIMERS; i++) {
+        tw->timers[i].fn = NULL;
+        tw->timers[i].data = NULL;
+        tw->timers[i].level = -1;
+        tw->timers[i].gen = 1;
+        tw->timers[i].prev = -1;
+        tw->timers[i].next = (i + 1 < TW_MAX_TIMERS) ? i + 1 : -1;
+    }
+    tw->freelist = 0;
+    tw->tick = 0;
+    tw->base_ms = now_ms;
+    tw->fired = 0;
+}
+
+static void tw_link(TimerWheel *tw, int16_t i) {
+    /* Put a timer in the right slot for how far off it is. Anything further
+     * out than the wheel covers waits in the last level and gets cascaded
+     * again when it comes around. */
+    Timer *t = &tw->timers[i];
+    long delta = t->expires - tw->tick;
+    long e = t->expires;
+    int level = 0;
+    if(delta < TW_SLOTS) {
+        level = 0;
+    } else if(delta < (TW_SLOTS << TW_BITS)) {
+        level = 1;
+    } else {
+        level = 2;
+        if(delta >= (TW_SLOTS << (2 * TW_BITS))) {
+            e = tw->tick + (TW_SLOTS << (2 * TW_BITS)) - 1;
+        }
+    }
+    t->level = level;
+    t->slot = (e >> (level * TW_BITS)) & (TW_SLOTS - 1);
+    t->prev = -1;
+    t->next = tw->slots[level][t->slot];
+    if(t->next != -1) tw->timers[t->next].prev = i;
+    tw->slots[level][t->slot] = i;
+    tw->used[level] |= (1ULL << t->slot);
+}
+
+static void tw_unlink(TimerWheel *tw, int16_t i) {
+    Timer *t = &tw->timers[i];
+    if(t->prev != -1) {
+        tw->timers[t->prev].next = t->next;
+    } else {
+        tw->slots[t->level][t->slot] = t->next;
+    }
+    if(t->next != -1) tw->timers[t->next].prev = t->prev;
+    if(tw->slots[t->level][t->slot] == -1) {
+        tw->used[t->level] &= ~(1ULL << t->slot);
+    }
+    t->level = -1;
+}
+
+static void tw_release(TimerWheel *tw, int16_t i) {
+    // Back on the free list, with a new generation so old ids stop working
+    Timer *t = &tw->timers[i];
+    t->gen++;
+    if(!t->gen) t->gen = 1;
+    t->fn = NULL;
+    t->data = NULL;
+    t->next = tw->freelist;
+    tw->freelist = i;
+}
+
+int tw_add(TimerWheel *tw, long now_ms, long delay_ms, TimerFn fn, void *data) {
+    /* Call fn(data) once, delay_ms from now_ms. Returns an id that can be
+     * passed to tw_cancel(), or -1 if all of the timers are in use. */
+    int16_t i = tw->freelist;
+    Timer *t = NULL;
+    long e = 0;
+    if((i == -1) || !fn) return -1;
+    t = &tw->timers[i];
+    tw->freelist = t->next;
+    if(delay_ms < 0) delay_ms = 0;
+    // Round up, a timer never goes off early
+    e = (now_ms + delay_ms - tw->base_ms + TW_TICK_MS - 1) / TW_TICK_MS;
+    if(e <= tw->tick) e = tw->tick + 1;
+    t->fn = fn;
+    t->data = data;
+    t->expires = e;
+    tw_link(tw, i);
+    return TW_ID(i, t->gen);
+}
+
+void tw_cancel(TimerWheel *tw, int id) {
+    int i = TW_ID_INDEX(id);
+    if((id < 0) || (i >= TW_MAX_TIMERS)) return;
+    if(tw->timers[i].gen != TW_ID_GEN(id)) return;
+    if(tw->timers[i].level == -1) return;
+    tw_unlink(tw, i);
+    tw_release(tw, i);
+}
+
+static void tw_cascade(TimerWheel *tw, int level) {
+    // Re-file every timer in this level's current slot, one level (or more)
+    // closer to going off.
+    int slot = (tw->tick >> (level * TW_BITS)) & (TW_SLOTS - 1);
+    int16_t i = tw->slots[level][slot];
+    while(i != -1) {
+        tw_unlink(tw, i);
+        tw_link(tw, i);
+        i = tw->slots[level][slot];
+    }
+}
+
+void tw_advance(TimerWheel *tw, long now_ms) {
+    /* Run the clock forward to now_ms, calling every timer that went off along
+     * the way (in order). Stretches of empty slots are skipped over instead
+     * of being stepped through a tick at a time. */
+    long target = (now_ms - tw->base_ms) / TW_TICK_MS;
+    long skip = 0;
+    int16_t i = -1;
+    int slot = 0;
+    TimerFn fn = NULL;
+    void *data = NULL;
+    while(tw->tick < target) {
+        if(!tw->used[0]) {
+            // Nothing due before the next cascade, jump right up to it
+            skip = tw->tick | (TW_SLOTS - 1);
+            if(!tw->used[1]) skip = tw->tick | ((TW_SLOTS << TW_BITS) - 1);
+            if(!tw->used[1] && !tw->used[2]) skip = target;
+            if(skip >= target) {
+                tw->tick = target;
+                break;
+            }
+            tw->tick = skip;
+        }
+        tw->tick++;
+        if((tw->tick & (TW_SLOTS - 1)) == 0) {
+            if((tw->tick & ((TW_SLOTS << TW_BITS) - 1)) == 0) {
+                tw_cascade(tw, 2);
+            }
+            tw_cascade(tw, 1);
+        }
+        slot = tw->tick & (TW_SLOTS - 1);
+        while((i = tw->slots[0][slot]) != -1) {
+            fn = tw->timers[i].fn;
+            data = tw->timers[i].data;
+            tw_unlink(tw, i);
+            tw_release(tw, i);
+            tw->fired++;
+            fn(data); // Might add more timers, which is fine
+        }
+    }
+}
+
+long tw_next(TimerWheel *tw, long now_ms) {
+    /* How many ms until something needs to happen (a timer going off, or a
+     * cascade that will bring one closer), -1 if there are no timers. */
+    uint64_t bits = 0;
+    long cur = 0, when = -1, t = 0;
+    int level = 0;
+    for(level = 0; level < TW_LEVELS; level++) {
+        if(!tw->used[level]) continue;
+        // Bit k of the rotated bitmap is the slot k+1 steps from now
+        cur = tw->tick >> (level * TW_BITS);
+        bits = rotr64(tw->used[level], (int)((cur + 1) & (TW_SLOTS - 1)));
+        t = (cur + 1 + __builtin_ctzll(bits)) << (level * TW_BITS);
+        if((when < 0) || (t < when)) when = t;
+    }
+    if(when < 0) return -1;
+    when = tw->base_ms + (when * TW_TICK_MS) - now_ms;
+    return (when > 0) ? when : 0;
+}